@@ -0,0 +1,126 @@
+/* compact.h
+*
+*  Stream compaction of the edge list between Boruvka rounds: the edges
+*  that became self-loops of a component are dropped and the live ones
+*  are rewritten in terms of component labels. Every thread counts the
+*  live edges of its chunk, the counts are scanned and every thread then
+*  scatters its chunk from its offset, so the edge order is kept.
+*
+*  Once the edges are sorted by (v1, v2, weight) a segmented unique keeps
+*  only the lightest of the parallel edges between two components.
+*
+*/
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <vector>
+
+#include "graph.h"
+#include "parallel.h"
+#include "scan.h"
+#include "isa_dispatch.h"
+
+/* Below this many edges per thread the compaction runs serially */
+#define COMPACT_MIN_CHUNK 16384
+
+/* Compacts the live edges of E into EO, the smaller label becomes v1
+*
+*  ids => original index of every edge of E, carried along into idsOut
+*  comp => component label of every vertex
+*
+*  returns the number of live edges written to EO / idsOut
+*/
+inline int compactEdges(const Edge* E, const int* ids, int numEdges, const int* comp,
+                        Edge* EO, int* idsOut, int numThreads) {
+    if (numThreads > numEdges / COMPACT_MIN_CHUNK) numThreads = numEdges / COMPACT_MIN_CHUNK;
+    if (numThreads < 1) numThreads = 1;
+
+    int chunk = (numEdges + numThreads - 1) / numThreads;
+    std::vector<int> counts(numThreads, 0);
+
+    /* Counts the live edges of every chunk */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            int first = t * chunk, last = first + chunk < numEdges ? first + chunk : numEdges;
+
+            counts[t] = isa().countLiveEdges(E, comp, first, last);
+        }
+    });
+
+    int live = exclusiveScan(&counts[0], &counts[0], numThreads, 1);
+
+    /* Scatters every chunk from its offset */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            int first = t * chunk, last = first + chunk < numEdges ? first + chunk : numEdges;
+            int pos = counts[t];
+
+            for(int i = first; i < last; i++) {
+                int c1 = comp[E[i].v1]
+                ,   c2 = comp[E[i].v2];
+
+                if (c1 == c2) continue;
+
+                EO[pos].v1 = c1 < c2 ? c1 : c2;
+                EO[pos].v2 = c1 < c2 ? c2 : c1;
+                EO[pos].w = E[i].w;
+                idsOut[pos++] = ids[i];
+            }
+        }
+    });
+
+    return live;
+}
+
+/* Whether E[i] starts a run of parallel edges */
+inline bool isSegmentHead(const Edge* E, int i) {
+    return i == 0 || E[i].v1 != E[i - 1].v1 || E[i].v2 != E[i - 1].v2;
+}
+
+/* Segmented unique of sorted edges: keeps the first (lightest) edge of
+*  every run with the same endpoints
+*
+*  returns the number of edges written to EO / idsOut
+*/
+inline int uniqueEdges(const Edge* E, const int* ids, int numEdges, Edge* EO, int* idsOut,
+                       int numThreads) {
+    if (numThreads > numEdges / COMPACT_MIN_CHUNK) numThreads = numEdges / COMPACT_MIN_CHUNK;
+    if (numThreads < 1) numThreads = 1;
+
+    int chunk = (numEdges + numThreads - 1) / numThreads;
+    std::vector<int> counts(numThreads, 0);
+
+    /* Counts the runs starting in every chunk */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            int first = t * chunk, last = first + chunk < numEdges ? first + chunk : numEdges;
+            int count = 0;
+
+            for(int i = first; i < last; i++)
+                if (isSegmentHead(E, i)) count++;
+            counts[t] = count;
+        }
+    });
+
+    int unique = exclusiveScan(&counts[0], &counts[0], numThreads, 1);
+
+    /* Scatters the heads of every chunk from its offset */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            int first = t * chunk, last = first + chunk < numEdges ? first + chunk : numEdges;
+            int pos = counts[t];
+
+            for(int i = first; i < last; i++) {
+                if (!isSegmentHead(E, i)) continue;
+
+                EO[pos] = E[i];
+                idsOut[pos++] = ids[i];
+            }
+        }
+    });
+
+    return unique;
+}
+
+#endif
@@ -0,0 +1,102 @@
+/* concurrent_union_find.h
+*
+*  Lock-free disjoint sets that many threads can Find/Union at once
+*  (Anderson-Woll / Jayanti-Tarjan style). Parent links only change by
+*  CAS; roots are linked by a fixed pseudo-random priority, so priorities
+*  strictly increase towards the root and no cycle can ever form.
+*
+*/
+
+#ifndef CONCURRENT_UNION_FIND_H
+#define CONCURRENT_UNION_FIND_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+/* struct(ure) Concurrent_Union_Find holds the forest of the disjoint sets
+*
+*  numElements => number of elements (vertices)
+*  parent => parent of each element, roots point to themselves
+*/
+struct Concurrent_Union_Find {
+    int numElements;
+    std::atomic<uint32_t>* parent;
+};
+
+/* Creates the sets - one per element */
+inline Concurrent_Union_Find MakeConcurrentSets(int numElements) {
+    Concurrent_Union_Find uf;
+
+    uf.numElements = numElements;
+    uf.parent = new std::atomic<uint32_t>[numElements];
+
+    for(int i = 0; i < numElements; i++)
+        uf.parent[i].store(i, std::memory_order_relaxed);
+
+    return uf;
+}
+
+/* Linking priority of an element - a bijective hash, so every element
+*  gets a distinct, randomly spread priority
+*/
+inline uint32_t linkPriority(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+
+    return x;
+}
+
+/* Finds the root of the element, halving the path with CAS on the way */
+inline uint32_t FindConcurrent(Concurrent_Union_Find &uf, uint32_t x) {
+    for (;;) {
+        uint32_t p = uf.parent[x].load(std::memory_order_acquire);
+        if (p == x) return x;
+
+        uint32_t gp = uf.parent[p].load(std::memory_order_acquire);
+        if (p != gp) {
+            uint32_t expected = p;
+            uf.parent[x].compare_exchange_weak(expected, gp, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed);
+        }
+
+        x = gp;
+    }
+}
+
+/* Merges the sets of two elements, the root with the lower priority goes
+*  under the other one. Safe to call from many threads at once.
+*
+*  returns true for exactly one caller per merge, false if they already
+*  were in the same set
+*/
+inline bool UnionConcurrent(Concurrent_Union_Find &uf, uint32_t x, uint32_t y) {
+    for (;;) {
+        x = FindConcurrent(uf, x);
+        y = FindConcurrent(uf, y);
+
+        if (x == y) return false;
+
+        if (linkPriority(x) > linkPriority(y)) {
+            uint32_t temp = x;
+            x = y;
+            y = temp;
+        }
+
+        /* Fails if x stopped being a root meanwhile - retries from there */
+        uint32_t expected = x;
+        if (uf.parent[x].compare_exchange_strong(expected, y, std::memory_order_acq_rel))
+            return true;
+    }
+}
+
+/* Releases the parent array of the sets */
+inline void FreeConcurrentSets(Concurrent_Union_Find &uf) {
+    delete [] uf.parent;
+    uf.parent = NULL;
+}
+
+#endif
@@ -0,0 +1,480 @@
+/* cpu_boruvka.h
+*
+*  Multi-threaded Boruvka engine that runs the same rounds as the OpenCL
+*  pipeline straight on host threads - no runtime, no buffer copies and
+*  no Kernel compilation:
+*
+*  min-edge => one pass over the live edges, folding a packed
+*              (weight, edge) key into both components with a CAS min;
+*              the first round scans the CSR slices with SIMD instead,
+*              when the input comes with them
+*  hook => every component unions itself along its minimum edge in the
+*          lock-free union-find
+*  compress => every vertex takes on the root of its set
+*  compact => self-loops and all but the lightest parallel edge are
+*             dropped (compaction, radix sort and segmented unique)
+*
+*  Once the contracted graph is small enough the rounds stop and the
+*  rest of the MST is finished sequentially (finish_mst.h).
+*
+*  compressedBoruvkaMST runs the same rounds over a compressed graph
+*  (compressed_graph.h): one decode pass per round folds the minimum
+*  edges and counts the live ones, skipping the blocks without any; once
+*  a quarter or less of the edges are live, contraction rewrites them -
+*  relabeled, without the parallel ones - into a fresh compressed graph,
+*  so the later rounds decode only those.
+*
+*/
+
+#ifndef CPU_BORUVKA_H
+#define CPU_BORUVKA_H
+
+#include <atomic>
+#include <utility>
+#include <stdint.h>
+
+#include "graph.h"
+#include "parallel.h"
+#include "concurrent_union_find.h"
+#include "compact.h"
+#include "radix_sort.h"
+#include "isa_dispatch.h"
+#include "finish_mst.h"
+#include "compressed_graph.h"
+
+/* Key of a component without outgoing edges */
+#define NO_EDGE_KEY UINT64_MAX
+
+/* The compressed engine rebuilds its graph once at most 1 / this share of
+*  the edges are live
+*/
+#define COMPRESSED_CONTRACT_SHARE 4
+
+/* Packs (weight, edge) into one key ordered by weight, then edge index */
+inline uint64_t packEdgeKey(int w, int index) {
+    return ((uint64_t) ((uint32_t) w ^ 0x80000000u) << 32) | (uint32_t) index;
+}
+
+/* Lowers the key of a component to key if that's smaller */
+inline void atomicMinKey(std::atomic<uint64_t> &target, uint64_t key) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+
+    while (key < current
+           && !target.compare_exchange_weak(current, key, std::memory_order_relaxed)) {
+    }
+}
+
+/* Minimum edge of vertex v over its CSR slice, with the SIMD scan of
+*  isa_dispatch.h; -1 if it has none
+*
+*  Self-loops (and ids out of ES) are skipped: should the scan land on
+*  one, the slice is scanned again, one entry at a time, without them
+*/
+inline int sliceMinEdge(const CSR_Graph &csr, const Edge* ES, int numEdges, int v) {
+    int first = csr.offsets[v]
+    ,   last = csr.offsets[v + 1]
+    ,   e = minEdgeInSlice(csr.weights + first, csr.edgeIds + first, last - first);
+
+    if (e < 0 || ((unsigned) e < (unsigned) numEdges && ES[e].v1 != ES[e].v2)) return e;
+
+    e = -1;
+    for(int k = first; k < last; k++) {
+        int id = csr.edgeIds[k];
+
+        if (csr.neighbors[k] == v || (unsigned) id >= (unsigned) numEdges) continue;
+        if (e < 0 || ES[id].w < ES[e].w || (ES[id].w == ES[e].w && id < e)) e = id;
+    }
+    return e;
+}
+
+/* Finds the MST with Boruvka's rounds on numThreads host threads - a
+*  spanning forest if the graph isn't connected
+*
+*  ES => edge list of the graph, left untouched
+*  csr => its CSR form with edgeIds (a mapped graph file), or NULL; the
+*         first round - every vertex its own component - then takes the
+*         minimum edge of every vertex with a SIMD scan of its slice, no
+*         atomics. The later rounds stay edge-parallel: the contracted
+*         edges have no slices, and building them every round costs more
+*         than the one pass of CAS minimums
+*  mstEdges => indices into ES of the MST edges, holds numVertices - 1
+*  rounds => number of Boruvka rounds it took
+*  finish => when to switch to the sequential finish, raises finished
+*  returns the number of MST edges
+*/
+inline int cpuBoruvkaMST(const Edge* ES, int numEdges, int numVertices, const CSR_Graph* csr,
+                         int* mstEdges, int &rounds, Hybrid_Finish &finish, int numThreads) {
+    Concurrent_Union_Find uf = MakeConcurrentSets(numVertices);
+    std::atomic<uint64_t>* minKey = new std::atomic<uint64_t>[numVertices];
+    std::atomic<int> mstCount(0);
+    int* comp = new int[numVertices];
+    Edge* E = new Edge[numEdges];
+    Edge* EO = new Edge[numEdges];
+    int* ids = new int[numEdges];
+    int* idsOut = new int[numEdges];
+
+    int minWeight = 0
+    ,   maxWeight = 0;
+
+    isa().weightRange(ES, numEdges, &minWeight, &maxWeight);
+
+    parallelFor(numEdges, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            E[i] = ES[i];
+            ids[i] = i;
+        }
+    });
+
+    int components = numVertices;
+
+    rounds = 0;
+    while (components > 1) {
+        /* Min-edge: E is still ES in the first round, the slices' edge
+        *  ids are its positions
+        */
+        if (rounds == 0 && csr != NULL) {
+            parallelFor(numVertices, numThreads, [&](int begin, int end) {
+                for(int v = begin; v < end; v++) {
+                    int e = sliceMinEdge(*csr, ES, numEdges, v);
+
+                    minKey[v].store(e < 0 ? NO_EDGE_KEY : packEdgeKey(ES[e].w, e),
+                                    std::memory_order_relaxed);
+                }
+            });
+        } else {
+            /* Every live edge crosses two components */
+            parallelFor(numVertices, numThreads, [&](int begin, int end) {
+                for(int v = begin; v < end; v++)
+                    minKey[v].store(NO_EDGE_KEY, std::memory_order_relaxed);
+            });
+
+            parallelFor(numEdges, numThreads, [&](int begin, int end) {
+                for(int i = begin; i < end; i++) {
+                    /* A self-loop of the input never joins two components */
+                    if (E[i].v1 == E[i].v2) continue;
+
+                    uint64_t key = packEdgeKey(E[i].w, i);
+
+                    atomicMinKey(minKey[E[i].v1], key);
+                    atomicMinKey(minKey[E[i].v2], key);
+                }
+            });
+        }
+
+        /* Hook: an edge picked by both its components merges them once */
+        int before = mstCount.load();
+
+        parallelFor(numVertices, numThreads, [&](int begin, int end) {
+            for(int c = begin; c < end; c++) {
+                uint64_t key = minKey[c].load(std::memory_order_relaxed);
+                if (key == NO_EDGE_KEY) continue;
+
+                int e = (int) (key & 0xffffffff);
+                if (UnionConcurrent(uf, E[e].v1, E[e].v2))
+                    mstEdges[mstCount.fetch_add(1)] = ids[e];
+            }
+        });
+
+        int added = mstCount.load() - before;
+
+        /* No edges left between the components */
+        if (added == 0) break;
+
+        components -= added;
+        rounds++;
+
+        /* Compress: every vertex points straight at its root */
+        parallelFor(numVertices, numThreads, [&](int begin, int end) {
+            for(int v = begin; v < end; v++)
+                comp[v] = (int) FindConcurrent(uf, v);
+        });
+
+        /* Compact: drops the self-loops, then the parallel edges */
+        numEdges = compactEdges(E, ids, numEdges, comp, EO, idsOut, numThreads);
+        std::swap(E, EO);
+        std::swap(ids, idsOut);
+
+        radixSortEdges(E, ids, numEdges, numVertices, minWeight, maxWeight, EO, idsOut, numThreads);
+        numEdges = uniqueEdges(E, ids, numEdges, EO, idsOut, numThreads);
+        std::swap(E, EO);
+        std::swap(ids, idsOut);
+
+        /* Finish: the contracted graph is small enough for one thread */
+        if (shouldFinish(finish, components, numEdges)) {
+            int count = mstCount.load();
+
+            mstCount.store(count + finishMST(finish, E, ids, numEdges, numVertices,
+                                             mstEdges + count));
+            finish.finished = true;
+            break;
+        }
+    }
+
+    FreeConcurrentSets(uf);
+    delete [] minKey;
+    delete [] comp;
+    delete [] E;
+    delete [] EO;
+    delete [] ids;
+    delete [] idsOut;
+
+    return mstCount.load();
+}
+
+/* Counts the live edges of every block of a compressed graph - those
+*  between two components - and returns their sum; a block without any
+*  stays dead, its edges are inside a component for good
+*
+*  liveCount => per block, numBlocks + 1 (the last one set to 0)
+*/
+inline int countLiveEdges(const Compressed_Graph &graph, const int* comp, int* liveCount,
+                          int numThreads) {
+    parallelFor(graph.numBlocks, numThreads, [&](int begin, int end) {
+        for(int b = begin; b < end; b++) {
+            if (liveCount[b] == 0) continue;
+
+            Compressed_Cursor cursor = openCursor(graph, b, b + 1);
+            Edge edge;
+            int position
+            ,   count = 0;
+
+            while (nextEdge(cursor, edge, position))
+                if (comp[edge.v1] != comp[edge.v2]) count++;
+            liveCount[b] = count;
+        }
+    });
+
+    liveCount[graph.numBlocks] = 0;
+    return parallelReduce<int>(graph.numBlocks, numThreads, 0, [&](int begin, int end) {
+        int count = 0;
+
+        for(int b = begin; b < end; b++)
+            count += liveCount[b];
+        return count;
+    }, [](int a, int b) { return a + b; });
+}
+
+/* Expands the live edges of a compressed graph into E, between their
+*  labels (smaller one first), their ids into ids
+*
+*  liveCount => live edges of every block as comp leaves them
+*  returns the number of live edges
+*/
+inline int expandLiveEdges(const Compressed_Graph &graph, const int* comp, int* liveCount,
+                           Edge* E, int* ids, int numThreads) {
+    int* offsets = new int[graph.numBlocks + 1];
+    int numEdges = exclusiveScan(liveCount, offsets, graph.numBlocks + 1, numThreads);
+
+    parallelFor(graph.numBlocks, numThreads, [&](int begin, int end) {
+        for(int b = begin; b < end; b++) {
+            if (liveCount[b] == 0) continue;
+
+            Compressed_Cursor cursor = openCursor(graph, b, b + 1);
+            Edge edge;
+            int position
+            ,   pos = offsets[b];
+
+            while (nextEdge(cursor, edge, position)) {
+                int c1 = comp[edge.v1]
+                ,   c2 = comp[edge.v2];
+
+                if (c1 == c2) continue;
+
+                E[pos].v1 = c1 < c2 ? c1 : c2;
+                E[pos].v2 = c1 < c2 ? c2 : c1;
+                E[pos].w = edge.w;
+                ids[pos++] = compressedEdgeId(graph, position);
+            }
+        }
+    });
+
+    delete [] offsets;
+    return numEdges;
+}
+
+/* Contracts a compressed graph: its live edges, relabeled with their
+*  components, are sorted, only the lightest of the parallel ones kept,
+*  and compressed again with their ids. The expansion holds about 32
+*  bytes per live edge for the sort, hence only once few are left.
+*/
+inline Compressed_Graph contractCompressedGraph(const Compressed_Graph &graph, const int* comp,
+                                                int* liveCount, int numThreads) {
+    int numEdges = countLiveEdges(graph, comp, liveCount, numThreads);
+    Edge* E = new Edge[numEdges + 1];
+    Edge* EO = new Edge[numEdges + 1];
+    int* ids = new int[numEdges + 1];
+    int* idsOut = new int[numEdges + 1];
+
+    expandLiveEdges(graph, comp, liveCount, E, ids, numThreads);
+    radixSortEdges(E, ids, numEdges, graph.numVertices, graph.minWeight, graph.maxWeight,
+                   EO, idsOut, numThreads);
+    numEdges = uniqueEdges(E, ids, numEdges, EO, idsOut, numThreads);
+
+    Compressed_Graph contracted = compressSortedEdges(EO, numEdges, graph.numVertices,
+                                                      numThreads);
+
+    contracted.edgeIds = idsOut;
+    delete [] E;
+    delete [] EO;
+    delete [] ids;
+
+    return contracted;
+}
+
+/* Finds the MST with Boruvka's rounds over a compressed graph on
+*  numThreads host threads - a spanning forest if it isn't connected
+*
+*  mstEdges => ids of the MST edges (their position in the sorted edge
+*              list), holds numVertices - 1
+*  rounds, finish => as cpuBoruvkaMST
+*  returns the number of MST edges
+*/
+inline int compressedBoruvkaMST(const Compressed_Graph &input, int* mstEdges, int &rounds,
+                                Hybrid_Finish &finish, int numThreads) {
+    int numVertices = input.numVertices;
+    Compressed_Graph graph = input;
+    bool contracted = false;
+    Concurrent_Union_Find uf = MakeConcurrentSets(numVertices);
+    std::atomic<uint64_t>* minKey = new std::atomic<uint64_t>[numVertices];
+    std::atomic<int> mstCount(0);
+    int* comp = new int[numVertices];
+    int* liveCount = new int[graph.numBlocks + 1];
+
+    parallelFor(numVertices, numThreads, [&](int begin, int end) {
+        for(int v = begin; v < end; v++)
+            comp[v] = v;
+    });
+    parallelFor(graph.numBlocks, numThreads, [&](int begin, int end) {
+        for(int b = begin; b < end; b++)
+            liveCount[b] = 1;
+    });
+
+    int components = numVertices;
+
+    rounds = 0;
+    while (components > 1) {
+        /* Min-edge: decodes the blocks that still have live edges,
+        *  counting them on the way - a block without any stays dead
+        */
+        parallelFor(numVertices, numThreads, [&](int begin, int end) {
+            for(int v = begin; v < end; v++)
+                minKey[v].store(NO_EDGE_KEY, std::memory_order_relaxed);
+        });
+
+        parallelFor(graph.numBlocks, numThreads, [&](int begin, int end) {
+            for(int b = begin; b < end; b++) {
+                if (liveCount[b] == 0) continue;
+
+                Compressed_Cursor cursor = openCursor(graph, b, b + 1);
+                Edge edge;
+                int position
+                ,   count = 0;
+
+                while (nextEdge(cursor, edge, position)) {
+                    int c1 = comp[edge.v1]
+                    ,   c2 = comp[edge.v2];
+
+                    if (c1 == c2) continue;
+
+                    uint64_t key = packEdgeKey(edge.w, position);
+                    atomicMinKey(minKey[c1], key);
+                    atomicMinKey(minKey[c2], key);
+                    count++;
+                }
+                liveCount[b] = count;
+            }
+        });
+
+        liveCount[graph.numBlocks] = 0;
+        int numEdges = parallelReduce<int>(graph.numBlocks, numThreads, 0, [&](int begin, int end) {
+            int count = 0;
+
+            for(int b = begin; b < end; b++)
+                count += liveCount[b];
+            return count;
+        }, [](int a, int b) { return a + b; });
+
+        /* Finish: only now are the live edges expanded, between labels */
+        if (shouldFinish(finish, components, numEdges)) {
+            Edge* E = new Edge[numEdges + 1];
+            Edge* EO = new Edge[numEdges + 1];
+            int* ids = new int[numEdges + 1];
+            int* idsOut = new int[numEdges + 1];
+
+            expandLiveEdges(graph, comp, liveCount, E, ids, numThreads);
+            radixSortEdges(E, ids, numEdges, numVertices, graph.minWeight, graph.maxWeight,
+                           EO, idsOut, numThreads);
+            numEdges = uniqueEdges(E, ids, numEdges, EO, idsOut, numThreads);
+
+            int count = mstCount.load();
+
+            mstCount.store(count + finishMST(finish, EO, idsOut, numEdges, numVertices,
+                                             mstEdges + count));
+            finish.finished = true;
+
+            delete [] E;
+            delete [] EO;
+            delete [] ids;
+            delete [] idsOut;
+            break;
+        }
+
+        /* Hook: the endpoints of the picked edge come from its block */
+        int before = mstCount.load();
+
+        parallelFor(numVertices, numThreads, [&](int begin, int end) {
+            for(int c = begin; c < end; c++) {
+                uint64_t key = minKey[c].load(std::memory_order_relaxed);
+                if (key == NO_EDGE_KEY) continue;
+
+                int position = (int) (key & 0xffffffff);
+                Edge edge = decodeEdge(graph, position);
+
+                if (UnionConcurrent(uf, edge.v1, edge.v2))
+                    mstEdges[mstCount.fetch_add(1)] = compressedEdgeId(graph, position);
+            }
+        });
+
+        int added = mstCount.load() - before;
+
+        /* No edges left between the components */
+        if (added == 0) break;
+
+        components -= added;
+        rounds++;
+
+        /* Relabel: every vertex takes on the label of its root */
+        parallelFor(numVertices, numThreads, [&](int begin, int end) {
+            for(int v = begin; v < end; v++)
+                comp[v] = (int) FindConcurrent(uf, v);
+        });
+
+        /* Contract: once few of its edges are live, the graph is rebuilt
+        *  from them, so the next rounds decode only those
+        */
+        if (numEdges <= graph.numEdges / COMPRESSED_CONTRACT_SHARE) {
+            Compressed_Graph next = contractCompressedGraph(graph, comp, liveCount, numThreads);
+
+            if (contracted) freeCompressedGraph(graph);
+            graph = next;
+            contracted = true;
+
+            delete [] liveCount;
+            liveCount = new int[graph.numBlocks + 1];
+            parallelFor(graph.numBlocks, numThreads, [&](int begin, int end) {
+                for(int b = begin; b < end; b++)
+                    liveCount[b] = 1;
+            });
+        }
+    }
+
+    if (contracted) freeCompressedGraph(graph);
+    FreeConcurrentSets(uf);
+    delete [] minKey;
+    delete [] comp;
+    delete [] liveCount;
+
+    return mstCount.load();
+}
+
+#endif
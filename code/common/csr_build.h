@@ -0,0 +1,113 @@
+/* csr_build.h
+*
+*  Multi-threaded construction of the CSR form (graph.h). The degrees are
+*  counted and the entries scattered with atomic cursors, then every slice
+*  is put back in edge order - the result is the very same as the one of
+*  the sequential buildCSR, whatever the number of threads. It works on
+*  the final edge list: the per-chunk buckets of the text parser are gone
+*  by then, merged, sorted and rid of parallel edges, and the generators
+*  and graph files have none.
+*
+*  numEdges => at most INT_MAX / 2, the slices hold 2 * numEdges entries
+*
+*/
+
+#ifndef CSR_BUILD_H
+#define CSR_BUILD_H
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "graph.h"
+#include "parallel.h"
+#include "scan.h"
+
+/* Builds the CSR form of an (undirected) edge list on numThreads */
+inline CSR_Graph buildCSR(const Edge* E, int numEdges, int numVertices, int numThreads) {
+    CSR_Graph graph;
+    std::atomic<int>* cursor = new std::atomic<int>[numVertices + 1];
+
+    graph.numVertices = numVertices;
+    graph.numEdges = numEdges;
+    graph.offsets = new int[numVertices + 1];
+    graph.neighbors = new int[2 * (size_t) numEdges];
+    graph.weights = new int[2 * (size_t) numEdges];
+    graph.edgeIds = new int[2 * (size_t) numEdges];
+
+    /* Counts the degree of every vertex */
+    parallelFor(numVertices + 1, numThreads, [&](int begin, int end) {
+        for(int v = begin; v < end; v++)
+            cursor[v].store(0, std::memory_order_relaxed);
+    });
+
+    parallelFor(numEdges, numThreads, [&](int begin, int end) {
+        for(int j = begin; j < end; j++) {
+            cursor[E[j].v1].fetch_add(1, std::memory_order_relaxed);
+            cursor[E[j].v2].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    /* Turns the degrees into slice offsets */
+    parallelFor(numVertices + 1, numThreads, [&](int begin, int end) {
+        for(int v = begin; v < end; v++)
+            graph.offsets[v] = cursor[v].load(std::memory_order_relaxed);
+    });
+    exclusiveScan(graph.offsets, graph.offsets, numVertices + 1, numThreads);
+
+    parallelFor(numVertices, numThreads, [&](int begin, int end) {
+        for(int v = begin; v < end; v++)
+            cursor[v].store(graph.offsets[v], std::memory_order_relaxed);
+    });
+
+    /* Scatters the edges into both endpoints' slices, in any order */
+    parallelFor(numEdges, numThreads, [&](int begin, int end) {
+        for(int j = begin; j < end; j++) {
+            int k1 = cursor[E[j].v1].fetch_add(1, std::memory_order_relaxed)
+            ,   k2 = cursor[E[j].v2].fetch_add(1, std::memory_order_relaxed);
+
+            graph.neighbors[k1] = E[j].v2;
+            graph.weights[k1] = E[j].w;
+            graph.edgeIds[k1] = j;
+
+            graph.neighbors[k2] = E[j].v1;
+            graph.weights[k2] = E[j].w;
+            graph.edgeIds[k2] = j;
+        }
+    });
+
+    /* Sorts every slice back into edge order */
+    parallelFor(numVertices, numThreads, [&](int begin, int end) {
+        std::vector<Edge> slice;
+
+        for(int v = begin; v < end; v++) {
+            int first = graph.offsets[v]
+            ,   last = graph.offsets[v + 1];
+
+            if (std::is_sorted(graph.edgeIds + first, graph.edgeIds + last)) continue;
+
+            /* (edge id, neighbor, weight) of every entry */
+            slice.resize(last - first);
+            for(int k = first; k < last; k++) {
+                slice[k - first].v1 = graph.edgeIds[k];
+                slice[k - first].v2 = graph.neighbors[k];
+                slice[k - first].w = graph.weights[k];
+            }
+
+            std::sort(slice.begin(), slice.end(), [](const Edge &a, const Edge &b) {
+                return a.v1 < b.v1;
+            });
+
+            for(int k = first; k < last; k++) {
+                graph.edgeIds[k] = slice[k - first].v1;
+                graph.neighbors[k] = slice[k - first].v2;
+                graph.weights[k] = slice[k - first].w;
+            }
+        }
+    });
+
+    delete [] cursor;
+    return graph;
+}
+
+#endif
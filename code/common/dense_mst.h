@@ -0,0 +1,300 @@
+/* dense_mst.h
+*
+*  Dense engine: finds the MST straight from the adjacency matrix, with
+*  neither the edge list nor its CSR form built. The matrix is a single
+*  contiguous, 64-byte aligned block (matrix.h); weights above 0 are
+*  edges, anything else is none.
+*
+*  prim => O(V^2) array-based Prim, one SIMD row relaxation and one SIMD
+*          argmin over the keys per vertex
+*  boruvka => row-min Boruvka: every component takes the minimum of its
+*             matrix row (in parallel), then the matrix is contracted to
+*             one row and column per component, at most half the size
+*
+*  Edges are ordered by weight, then by their code u * V + v (u < v), so
+*  every component agrees on one and the same minimum.
+*
+*/
+
+#ifndef DENSE_MST_H
+#define DENSE_MST_H
+
+#include <climits>
+#include <cstring>
+
+#include "graph.h"
+#include "matrix.h"
+#include "union_find.h"
+#include "parallel.h"
+#include "isa_dispatch.h"
+
+/* Default edge density E / V^2 above which the dense engine is picked */
+#define DENSE_ENGINE_DENSITY 0.25
+
+/* Largest graph whose edge codes u * V + v still fit an int */
+#define DENSE_MAX_VERTICES 46340
+
+/* Algorithms of the dense engine */
+enum Dense_Algorithm {
+    DENSE_PRIM,
+    DENSE_BORUVKA,
+    NUM_DENSE_ALGORITHMS
+};
+
+const char* const denseNames[NUM_DENSE_ALGORITHMS] = { "prim", "boruvka" };
+
+/* Whether a graph is dense enough for the dense engine
+*
+*  threshold => minimum edge density E / V^2
+*/
+inline bool preferDenseEngine(long long numEdges, int numVertices, double threshold) {
+    return numVertices > 1 && numVertices <= DENSE_MAX_VERTICES
+        && (double) numEdges / ((double) numVertices * numVertices) >= threshold;
+}
+
+/* Looks up a dense algorithm by name, false if it's unknown */
+inline bool parseDenseAlgorithm(const char* name, Dense_Algorithm &algorithm) {
+    for (int i = 0; i < NUM_DENSE_ALGORITHMS; i++) {
+        if (strcmp(name, denseNames[i]) == 0) {
+            algorithm = (Dense_Algorithm) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Array-based Prim over the matrix - a spanning forest if the graph
+*  isn't connected
+*
+*  matrix => the adjacency matrix, one row per vertex
+*  mst => output buffer, holds at least numRows - 1 edges
+*  returns the number of MST edges
+*/
+inline int densePrimMST(const Dense_Matrix &matrix, Edge* mst) {
+    int n = matrix.numRows;
+    int* key = new int[n];
+    int* from = new int[n];
+    int* inTree = new int[n];
+    int* columns = new int[n];
+    int t = 0
+    ,   next = 0;
+
+    for(int v = 0; v < n; v++) {
+        key[v] = INT_MAX;
+        from[v] = -1;
+        inTree[v] = 0;
+        columns[v] = v;
+    }
+
+    for(int added = 0; added < n; added++) {
+        int u = isa().minEdgeScan(key, columns, n);
+
+        if (key[u] == INT_MAX) {
+            /* Nothing reachable from the trees so far, starts a new one */
+            while (inTree[next]) next++;
+            u = next;
+        } else {
+            mst[t].v1 = from[u] < u ? from[u] : u;
+            mst[t].v2 = from[u] < u ? u : from[u];
+            mst[t].w = key[u];
+            t++;
+        }
+
+        inTree[u] = 1;
+        key[u] = INT_MAX;
+        isa().relaxRow(matrixRow(matrix, u), n, inTree, key, from, u);
+    }
+
+    delete [] key;
+    delete [] from;
+    delete [] inTree;
+    delete [] columns;
+
+    return t;
+}
+
+/* Contracts a matrix to one row and column per new component: every
+*  cell keeps the lightest (weight, code) edge between its components
+*
+*  cell(i, j, w, code) => edge between old rows i and j, false if none
+*  map => new component of every old row
+*  group, groupStart => old rows of every new component
+*  W, codes => new weights and edge codes, one row per new component
+*/
+template <typename Cell>
+void contractMatrix(int numOld, const int* map, const int* group, const int* groupStart,
+                    Dense_Matrix &W, Dense_Matrix &codes, Cell cell, int numThreads) {
+    int numNew = W.numRows;
+
+    parallelFor(numNew, numThreads, [&](int begin, int end) {
+        for(int a = begin; a < end; a++) {
+            int* row = matrixRow(W, a);
+            int* rowCodes = matrixRow(codes, a);
+
+            for(int b = 0; b < numNew; b++) {
+                row[b] = INT_MAX;
+                rowCodes[b] = INT_MAX;
+            }
+
+            for(int k = groupStart[a]; k < groupStart[a + 1]; k++) {
+                int i = group[k];
+
+                for(int j = 0; j < numOld; j++) {
+                    int b = map[j]
+                    ,   w
+                    ,   code;
+
+                    if (b == a || !cell(i, j, w, code)) continue;
+
+                    if (w < row[b] || (w == row[b] && code < rowCodes[b])) {
+                        row[b] = w;
+                        rowCodes[b] = code;
+                    }
+                }
+            }
+        }
+    });
+}
+
+/* Row-min Boruvka over the matrix - a spanning forest if the graph
+*  isn't connected
+*
+*  matrix => the adjacency matrix, one row per vertex
+*  mst => output buffer, holds at least numRows - 1 edges
+*  rounds => number of Boruvka rounds it took
+*  returns the number of MST edges
+*/
+inline int denseBoruvkaMST(const Dense_Matrix &matrix, Edge* mst, int &rounds, int numThreads) {
+    int n = matrix.numRows;
+    int* vertexComp = new int[n];
+    int* best = new int[n];
+    int* map = new int[n];
+    int* group = new int[n];
+    int* groupStart = new int[n + 1];
+    Dense_Matrix W = createMatrix(0, 0, false);
+    Dense_Matrix codes = createMatrix(0, 0, false);
+    bool contracted = false;
+    int numComps = n
+    ,   t = 0;
+
+    for(int v = 0; v < n; v++)
+        vertexComp[v] = v;
+
+    rounds = 0;
+    while (numComps > 1) {
+        /* Min-edge: the minimum of every component's row, as an edge code */
+        parallelFor(numComps, numThreads, [&](int begin, int end) {
+            for(int c = begin; c < end; c++) {
+                if (!contracted) {
+                    int v = isa().rowMin(matrixRow(matrix, c), n);
+                    best[c] = v < 0 ? INT_MAX : (c < v ? c * n + v : v * n + c);
+                } else {
+                    best[c] = isa().minEdgeScan(matrixRow(W, c), matrixRow(codes, c), numComps);
+                }
+            }
+        });
+
+        /* Hook: an edge picked by both its components merges them once */
+        Union_Find forest = MakeSets(numComps);
+        int added = 0;
+
+        for(int c = 0; c < numComps; c++) {
+            if (best[c] == INT_MAX) continue;
+
+            int u = best[c] / n
+            ,   v = best[c] % n
+            ,   other = vertexComp[u] == c ? vertexComp[v] : vertexComp[u];
+
+            if (Union(forest, c, other)) {
+                mst[t].v1 = u;
+                mst[t].v2 = v;
+                mst[t].w = matrixRow(matrix, u)[v];
+                t++;
+                added++;
+            }
+        }
+
+        /* No edges left between the components */
+        if (added == 0) {
+            FreeSets(forest);
+            break;
+        }
+
+        rounds++;
+
+        /* Relabel: every component gets the dense index of its root */
+        int numNew = 0;
+
+        for(int c = 0; c < numComps; c++)
+            map[c] = -1;
+        for(int c = 0; c < numComps; c++) {
+            int root = Find(forest, c);
+
+            if (map[root] < 0) map[root] = numNew++;
+        }
+        for(int c = 0; c < numComps; c++)
+            group[c] = map[Find(forest, c)];
+        for(int c = 0; c < numComps; c++)
+            map[c] = group[c];
+
+        FreeSets(forest);
+
+        for(int v = 0; v < n; v++)
+            vertexComp[v] = map[vertexComp[v]];
+
+        if (numNew == 1) break;
+
+        /* Groups the old rows by their new component */
+        for(int a = 0; a <= numNew; a++)
+            groupStart[a] = 0;
+        for(int c = 0; c < numComps; c++)
+            groupStart[map[c] + 1]++;
+        for(int a = 0; a < numNew; a++)
+            groupStart[a + 1] += groupStart[a];
+        for(int c = 0; c < numComps; c++)
+            group[groupStart[map[c]]++] = c;
+        for(int a = numNew; a > 0; a--)
+            groupStart[a] = groupStart[a - 1];
+        groupStart[0] = 0;
+
+        /* Contract: one row and column per new component */
+        Dense_Matrix newW = createMatrix(numNew, numNew, false);
+        Dense_Matrix newCodes = createMatrix(numNew, numNew, false);
+
+        if (!contracted) {
+            contractMatrix(numComps, map, group, groupStart, newW, newCodes,
+                           [&](int i, int j, int &w, int &code) {
+                w = matrixRow(matrix, i)[j];
+                code = i < j ? i * n + j : j * n + i;
+                return w > 0;
+            }, numThreads);
+        } else {
+            contractMatrix(numComps, map, group, groupStart, newW, newCodes,
+                           [&](int i, int j, int &w, int &code) {
+                w = matrixRow(W, i)[j];
+                code = matrixRow(codes, i)[j];
+                return w != INT_MAX;
+            }, numThreads);
+        }
+
+        freeMatrix(W);
+        freeMatrix(codes);
+        W = newW;
+        codes = newCodes;
+        contracted = true;
+        numComps = numNew;
+    }
+
+    freeMatrix(W);
+    freeMatrix(codes);
+    delete [] vertexComp;
+    delete [] best;
+    delete [] map;
+    delete [] group;
+    delete [] groupStart;
+
+    return t;
+}
+
+#endif
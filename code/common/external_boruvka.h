@@ -0,0 +1,377 @@
+/* external_boruvka.h
+*
+*  Semi-external Boruvka for edge lists larger than memory: only the
+*  vertex arrays - the union-find and the minimum edge of every
+*  component, 32 bytes per vertex - are in memory, the edges stream from
+*  disk in large sequential reads, a reader thread fetching the next
+*  block while the current one is scanned.
+*
+*  Every round is one pass over the live edges: each edge is relabeled
+*  with the roots of its endpoints, dropped if it became a self-loop,
+*  written to the spill file of the next round and folded into the
+*  minimum edge of both components for the next hook. The spill files
+*  shrink with the components; once the live edges fit in memoryEdges
+*  they are kept in memory instead and the rounds go on there, on the
+*  multi-threaded CPU engine (cpu_boruvka.h).
+*
+*/
+
+#ifndef EXTERNAL_BORUVKA_H
+#define EXTERNAL_BORUVKA_H
+
+#include <cstdio>
+#include <thread>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+#include "union_find.h"
+#include "cpu_boruvka.h"
+
+/* Edges of a read block and of a write buffer */
+#define EXTERNAL_BLOCK_EDGES (1 << 20)
+
+/* Live edges handed over to the CPU engine, about 50 bytes each there */
+#define EXTERNAL_MEMORY_EDGES (1 << 24)
+
+/* struct(ure) Spill_Edge is an edge of a spill file
+*
+*  v1, v2 => component labels of the endpoints
+*  w => weight of the edge
+*  id => index of the edge in the input edge list
+*/
+struct Spill_Edge {
+    int v1
+    ,   v2
+    ,   w
+    ,   id;
+};
+
+/* struct(ure) External_Options sets where the spill files go and how
+*  much of the edges is held in memory
+*
+*  spillDir => directory of the spill files
+*  blockEdges => edges of a read block (two are in flight) and of the
+*                write buffer
+*  memoryEdges => live edges below which the rounds go on in memory
+*/
+struct External_Options {
+    const char* spillDir;
+    int blockEdges
+    ,   memoryEdges;
+};
+
+/* struct(ure) External_Stats sums up the I/O of a run
+*
+*  bytesRead, bytesWritten => bytes streamed from and to disk
+*  spillRounds => rounds that wrote a spill file
+*/
+struct External_Stats {
+    uint64_t bytesRead
+    ,        bytesWritten;
+    int spillRounds;
+};
+
+/* Spill files in /tmp, the default block and memory sizes */
+inline External_Options defaultExternalOptions() {
+    External_Options options = { "/tmp", EXTERNAL_BLOCK_EDGES, EXTERNAL_MEMORY_EDGES };
+
+    return options;
+}
+
+/* Asks for readahead of a file read front to back */
+inline void adviseSequential(FILE* file) {
+#ifdef __linux__
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    (void) file;
+#endif
+}
+
+/* Streams count records of file to body(records, n), block after block;
+*  a reader thread fetches the next block while body runs
+*
+*  buffers => two blocks of blockRecords records
+*  returns false on a short read
+*/
+template <typename Record, typename Body>
+bool streamRecords(FILE* file, long long count, Record* buffers[2], int blockRecords,
+                   External_Stats &stats, Body body) {
+    size_t got[2] = { 0, 0 };
+    size_t want = (size_t) (count < blockRecords ? count : blockRecords);
+    long long done = 0;
+
+    got[0] = fread(buffers[0], sizeof(Record), want, file);
+    if (got[0] != want) return false;
+
+    for(int b = 0; done < count; b ^= 1) {
+        size_t next;
+        std::thread reader;
+
+        done += got[b];
+        got[b ^ 1] = 0;
+        next = (size_t) (count - done < blockRecords ? count - done : blockRecords);
+        if (next > 0) {
+            reader = std::thread([&got, &buffers, b, next, file]() {
+                got[b ^ 1] = fread(buffers[b ^ 1], sizeof(Record), next, file);
+            });
+        }
+
+        body(buffers[b], (int) got[b]);
+        stats.bytesRead += got[b] * sizeof(Record);
+
+        if (reader.joinable()) reader.join();
+        if (got[b ^ 1] != next) return false;
+    }
+
+    return true;
+}
+
+/* Lowers the minimum edge of component c to edge if that's lighter */
+inline void foldMinEdge(uint64_t* minKey, Spill_Edge* minEdge, int c, const Spill_Edge &edge) {
+    uint64_t key = packEdgeKey(edge.w, edge.id);
+
+    if (key < minKey[c]) {
+        minKey[c] = key;
+        minEdge[c] = edge;
+    }
+}
+
+/* Name of the spill file of a round */
+inline void spillPath(char* path, size_t size, const char* dir, int round) {
+#ifdef __linux__
+    snprintf(path, size, "%s/boruvka-spill-%d-%d.bin", dir, (int) getpid(), round);
+#else
+    snprintf(path, size, "%s/boruvka-spill-%d.bin", dir, round);
+#endif
+}
+
+/* Finds the MST of an edge list on disk - a spanning forest if the graph
+*  isn't connected - holding only the vertex arrays in memory
+*
+*  path, offset => file of the edges (Edge records, v1 < v2) and where
+*                  they start, say the edges section of a graph file
+*  mstEdges => indices of the MST edges in that list, numVertices - 1
+*  rounds => number of Boruvka rounds it took
+*  finish => when and how the CPU engine finishes, raises finished
+*  numThreads => threads of the CPU engine
+*  returns the number of MST edges, -1 on an I/O error
+*/
+inline int externalBoruvkaMST(const char* path, uint64_t offset, int numEdges, int numVertices,
+                              const External_Options &options, int* mstEdges, int &rounds,
+                              Hybrid_Finish &finish, External_Stats &stats, int numThreads) {
+    FILE* input = fopen(path, "rb");
+    if (input == NULL) return -1;
+
+    Union_Find uf = MakeSets(numVertices);
+    uint64_t* minKey = new uint64_t[numVertices];
+    Spill_Edge* minEdge = new Spill_Edge[numVertices];
+    Spill_Edge* blocks[2] = {
+        new Spill_Edge[options.blockEdges], new Spill_Edge[options.blockEdges]
+    };
+    Spill_Edge* writeBuffer = new Spill_Edge[options.blockEdges];
+    int memoryEdges = options.memoryEdges < numEdges ? options.memoryEdges : numEdges;
+    Edge* E = new Edge[memoryEdges + 1];
+    int* ids = new int[memoryEdges + 1];
+    char current[1024]
+    ,    next[1024];
+    bool ok = true
+    ,    spilled = true;
+    int count = 0;
+    long long live = numEdges;
+
+    stats.bytesRead = stats.bytesWritten = 0;
+    stats.spillRounds = 0;
+    current[0] = '\0';
+
+    for(int v = 0; v < numVertices; v++)
+        minKey[v] = NO_EDGE_KEY;
+
+    /* First scan, straight over the input edges */
+    adviseSequential(input);
+    ok = fseeko(input, (off_t) offset, SEEK_SET) == 0;
+    if (ok) {
+        Edge* edgeBlocks[2] = { (Edge*) blocks[0], (Edge*) blocks[1] };
+        int id = 0;
+
+        ok = streamRecords(input, numEdges, edgeBlocks, options.blockEdges, stats,
+                           [&](const Edge* block, int n) {
+            for(int i = 0; i < n; i++, id++) {
+                Spill_Edge edge = { block[i].v1, block[i].v2, block[i].w, id };
+
+                if (edge.v1 == edge.v2) continue;
+                foldMinEdge(minKey, minEdge, edge.v1, edge);
+                foldMinEdge(minKey, minEdge, edge.v2, edge);
+            }
+        });
+    }
+
+    rounds = 0;
+    while (ok && spilled) {
+        /* Hook: every component unions itself along its minimum edge */
+        int added = 0;
+
+        for(int c = 0; c < numVertices; c++) {
+            if (minKey[c] == NO_EDGE_KEY) continue;
+
+            if (Union(uf, minEdge[c].v1, minEdge[c].v2)) {
+                mstEdges[count++] = minEdge[c].id;
+                added++;
+            }
+            minKey[c] = NO_EDGE_KEY;
+        }
+
+        if (added == 0) break;
+        rounds++;
+
+        /* Contract: relabels the live edges, drops the self-loops and
+        *  spills the rest, keeping them in memory while they fit
+        */
+        FILE* from = current[0] == '\0' ? input : fopen(current, "rb");
+        FILE* to = NULL;
+        int inMemory = 0
+        ,   buffered = 0;
+        long long kept = 0;
+
+        if (from == NULL) {
+            ok = false;
+            break;
+        }
+        spillPath(next, sizeof(next), options.spillDir, rounds);
+        spilled = false;
+
+        if (from == input) {
+            ok = fseeko(input, (off_t) offset, SEEK_SET) == 0;
+        } else {
+            adviseSequential(from);
+        }
+
+        /* Writes the write buffer out to the spill file */
+        auto flush = [&]() {
+            if (to == NULL) {
+                to = fopen(next, "wb");
+                spilled = true;
+                if (to == NULL) {
+                    ok = false;
+                    buffered = 0;
+                    return;
+                }
+            }
+
+            ok = ok && fwrite(writeBuffer, sizeof(Spill_Edge), buffered, to) == (size_t) buffered;
+            stats.bytesWritten += (uint64_t) buffered * sizeof(Spill_Edge);
+            buffered = 0;
+        };
+
+        /* Takes one relabeled live edge */
+        auto keep = [&](const Spill_Edge &edge) {
+            if (!ok) return;
+
+            foldMinEdge(minKey, minEdge, edge.v1, edge);
+            foldMinEdge(minKey, minEdge, edge.v2, edge);
+            kept++;
+
+            if (!spilled && inMemory < memoryEdges) {
+                E[inMemory].v1 = edge.v1;
+                E[inMemory].v2 = edge.v2;
+                E[inMemory].w = edge.w;
+                ids[inMemory++] = edge.id;
+                return;
+            }
+
+            /* Out of memory: the edges held so far go first */
+            if (!spilled) {
+                for(int i = 0; i < inMemory; i++) {
+                    Spill_Edge held = { E[i].v1, E[i].v2, E[i].w, ids[i] };
+
+                    writeBuffer[buffered++] = held;
+                    if (buffered == options.blockEdges) flush();
+                }
+                inMemory = 0;
+                if (!spilled) flush();
+            }
+
+            writeBuffer[buffered++] = edge;
+            if (buffered == options.blockEdges) flush();
+        };
+
+        auto relabel = [&](int v1, int v2, int w, int id) {
+            int c1 = (int) Find(uf, v1)
+            ,   c2 = (int) Find(uf, v2);
+
+            if (c1 == c2) return;
+
+            Spill_Edge edge = { c1 < c2 ? c1 : c2, c1 < c2 ? c2 : c1, w, id };
+            keep(edge);
+        };
+
+        if (ok && from == input) {
+            Edge* edgeBlocks[2] = { (Edge*) blocks[0], (Edge*) blocks[1] };
+            int id = 0;
+
+            ok = streamRecords(input, numEdges, edgeBlocks, options.blockEdges, stats,
+                               [&](const Edge* block, int n) {
+                for(int i = 0; i < n; i++, id++)
+                    relabel(block[i].v1, block[i].v2, block[i].w, id);
+            });
+        } else if (ok) {
+            ok = streamRecords(from, live, blocks, options.blockEdges, stats,
+                               [&](const Spill_Edge* block, int n) {
+                for(int i = 0; i < n; i++)
+                    relabel(block[i].v1, block[i].v2, block[i].w, block[i].id);
+            });
+        }
+
+        if (spilled && buffered > 0) flush();
+        if (to != NULL) ok = fclose(to) == 0 && ok;
+
+        /* The spill file of the previous round is done with */
+        if (from != input) {
+            fclose(from);
+            remove(current);
+        }
+
+        live = kept;
+        if (spilled) {
+            stats.spillRounds++;
+            snprintf(current, sizeof(current), "%s", next);
+        } else {
+            current[0] = '\0';
+        }
+
+        /* The live edges fit in memory: the CPU engine takes over, its
+        *  edge indices go back to input ones through ids
+        */
+        if (ok && !spilled && inMemory > 0) {
+            int* found = new int[numVertices];
+            int more = 0
+            ,   t = cpuBoruvkaMST(E, inMemory, numVertices, NULL, found, more, finish,
+                                    numThreads);
+
+            for(int i = 0; i < t; i++)
+                mstEdges[count++] = ids[found[i]];
+            rounds += more;
+            delete [] found;
+        }
+    }
+
+    if (current[0] != '\0') remove(current);
+    fclose(input);
+
+    FreeSets(uf);
+    delete [] minKey;
+    delete [] minEdge;
+    delete [] blocks[0];
+    delete [] blocks[1];
+    delete [] writeBuffer;
+    delete [] E;
+    delete [] ids;
+
+    return ok ? count : -1;
+}
+
+#endif
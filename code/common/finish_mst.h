@@ -0,0 +1,195 @@
+/* finish_mst.h
+*
+*  Sequential finish of a hybrid Boruvka run. Once the contracted graph
+*  is small - few components or few live edges left - every further
+*  round costs more in launches and synchronization than in actual work,
+*  so the rest of the MST is found in one go by Kruskal or Prim on the
+*  contracted graph. Its component labels are first renumbered densely,
+*  which keeps the union-find (or the heap and CSR of Prim) of the
+*  finish cache-resident.
+*
+*/
+
+#ifndef FINISH_MST_H
+#define FINISH_MST_H
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#include "graph.h"
+#include "union_find.h"
+
+/* Default thresholds below which the engines switch to the finish */
+#define FINISH_MAX_COMPONENTS 1024
+#define FINISH_MAX_EDGES 8192
+
+/* Algorithms finishing the MST of the contracted graph */
+enum Finish_Algorithm {
+    FINISH_NONE,        /* Boruvka rounds until the end */
+    FINISH_KRUSKAL,     /* edges sorted by weight into a union-find */
+    FINISH_PRIM,        /* binary heap over the CSR form, tree by tree */
+    NUM_FINISH_ALGORITHMS
+};
+
+const char* const finishNames[NUM_FINISH_ALGORITHMS] = { "none", "kruskal", "prim" };
+
+/* struct(ure) Hybrid_Finish holds when and how a Boruvka run finishes
+*
+*  maxComponents, maxEdges => the finish starts after the first round
+*                             leaving at most that many components or
+*                             live edges
+*  finished => raised by the engine once it switched to the finish
+*/
+struct Hybrid_Finish {
+    Finish_Algorithm algorithm;
+    int maxComponents
+    ,   maxEdges;
+    bool finished;
+};
+
+/* Kruskal finish with the default thresholds */
+inline Hybrid_Finish defaultHybridFinish() {
+    Hybrid_Finish finish = { FINISH_KRUSKAL, FINISH_MAX_COMPONENTS, FINISH_MAX_EDGES, false };
+
+    return finish;
+}
+
+/* Looks up a finish algorithm by name, false if it's unknown */
+inline bool parseFinishAlgorithm(const char* name, Finish_Algorithm &algorithm) {
+    for (int i = 0; i < NUM_FINISH_ALGORITHMS; i++) {
+        if (strcmp(name, finishNames[i]) == 0) {
+            algorithm = (Finish_Algorithm) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Whether a run with components and numEdges live edges left finishes */
+inline bool shouldFinish(const Hybrid_Finish &finish, int components, int numEdges) {
+    return finish.algorithm != FINISH_NONE && components > 1
+        && (components <= finish.maxComponents || numEdges <= finish.maxEdges);
+}
+
+/* Renumbers the component labels of the live edges to 0..n-1
+*
+*  E => live edges, endpoints are labels below numVertices
+*  dense => the same edges over the new labels
+*  returns n, the number of labels in use
+*/
+inline int relabelDense(const Edge* E, int numEdges, int numVertices, Edge* dense) {
+    int* label = new int[numVertices];
+    int n = 0;
+
+    for(int i = 0; i < numVertices; i++)
+        label[i] = -1;
+
+    for(int i = 0; i < numEdges; i++) {
+        if (label[E[i].v1] < 0) label[E[i].v1] = n++;
+        if (label[E[i].v2] < 0) label[E[i].v2] = n++;
+
+        dense[i].v1 = label[E[i].v1];
+        dense[i].v2 = label[E[i].v2];
+        dense[i].w = E[i].w;
+    }
+
+    delete [] label;
+    return n;
+}
+
+/* Kruskal over edges with dense labels: ties on the weight go to the
+*  smaller edge index
+*/
+inline int kruskalFinish(const Edge* E, const int* ids, int numEdges, int n, int* mstEdges) {
+    Union_Find forest = MakeSets(n);
+    int* order = new int[numEdges];
+    int t = 0;
+
+    for(int i = 0; i < numEdges; i++)
+        order[i] = i;
+
+    std::sort(order, order + numEdges, [E](int a, int b) {
+        return E[a].w < E[b].w || (E[a].w == E[b].w && a < b);
+    });
+
+    for(int k = 0; k < numEdges && t < n - 1; k++) {
+        int e = order[k];
+
+        if (Union(forest, E[e].v1, E[e].v2))
+            mstEdges[t++] = ids[e];
+    }
+
+    FreeSets(forest);
+    delete [] order;
+
+    return t;
+}
+
+/* Prim over edges with dense labels, growing one tree per component of
+*  the contracted graph from a binary heap of (weight, edge, vertex)
+*/
+inline int primFinish(Edge* E, const int* ids, int numEdges, int n, int* mstEdges) {
+    typedef std::pair<std::pair<int, int>, int> Heap_Entry;
+
+    CSR_Graph graph = buildCSR(E, numEdges, n);
+    std::priority_queue<Heap_Entry, std::vector<Heap_Entry>, std::greater<Heap_Entry> > heap;
+    bool* inTree = new bool[n];
+    int t = 0;
+
+    for(int v = 0; v < n; v++)
+        inTree[v] = false;
+
+    for(int root = 0; root < n; root++) {
+        if (inTree[root]) continue;
+
+        heap.push(Heap_Entry(std::make_pair(0, -1), root));
+        while (!heap.empty()) {
+            Heap_Entry top = heap.top();
+            int v = top.second
+            ,   e = top.first.second;
+
+            heap.pop();
+            if (inTree[v]) continue;
+
+            inTree[v] = true;
+            if (e >= 0) mstEdges[t++] = ids[e];
+
+            for(int k = graph.offsets[v]; k < graph.offsets[v + 1]; k++) {
+                if (!inTree[graph.neighbors[k]])
+                    heap.push(Heap_Entry(std::make_pair(graph.weights[k], graph.edgeIds[k]),
+                                         graph.neighbors[k]));
+            }
+        }
+    }
+
+    freeCSR(graph);
+    delete [] inTree;
+
+    return t;
+}
+
+/* Finishes the MST of the contracted graph
+*
+*  E => live edges between the components, endpoints are labels below
+*       numVertices
+*  ids => original index of every live edge
+*  mstEdges => receives the original indices of the finishing MST edges
+*  returns the number of those edges
+*/
+inline int finishMST(const Hybrid_Finish &finish, const Edge* E, const int* ids, int numEdges,
+                     int numVertices, int* mstEdges) {
+    if (finish.algorithm == FINISH_NONE || numEdges == 0) return 0;
+
+    Edge* dense = new Edge[numEdges];
+    int n = relabelDense(E, numEdges, numVertices, dense)
+    ,   t = finish.algorithm == FINISH_PRIM ? primFinish(dense, ids, numEdges, n, mstEdges)
+                                            : kruskalFinish(dense, ids, numEdges, n, mstEdges);
+
+    delete [] dense;
+    return t;
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* graph.h
+*
+*  Graph representations shared by the sequential and parallel
+*  implementations: the plain edge list and its CSR form.
+*
+*/
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <cstddef>
+
+/* struct(ure) Edge holds information about the edge
+*
+*  v1 => vertex 1
+*  v2 => vertex 2
+*  w => weight of the edge
+*/
+struct Edge {
+    int v1
+    ,   v2
+    ,   w;
+};
+
+/* struct(ure) CSR_Graph holds the graph in compressed sparse row form,
+*  every undirected edge shows up in the adjacency of both its endpoints
+*
+*  offsets => vertex v owns the adjacency slice [offsets[v], offsets[v + 1])
+*  neighbors => vertex on the other side of each adjacency entry
+*  weights => weight of each adjacency entry
+*  edgeIds => index of each adjacency entry's edge in the edge list
+*/
+struct CSR_Graph {
+    int numVertices
+    ,   numEdges;
+    int* offsets;
+    int* neighbors;
+    int* weights;
+    int* edgeIds;
+};
+
+/* Builds the CSR form of an (undirected) edge list in O(V + E) */
+inline CSR_Graph buildCSR(Edge* E, int numEdges, int numVertices) {
+    CSR_Graph graph;
+
+    graph.numVertices = numVertices;
+    graph.numEdges = numEdges;
+    graph.offsets = new int[numVertices + 1];
+    graph.neighbors = new int[2 * numEdges];
+    graph.weights = new int[2 * numEdges];
+    graph.edgeIds = new int[2 * numEdges];
+
+    /* Counts the degree of every vertex */
+    for(int i = 0; i <= numVertices; i++)
+        graph.offsets[i] = 0;
+
+    for(int j = 0; j < numEdges; j++) {
+        graph.offsets[E[j].v1 + 1]++;
+        graph.offsets[E[j].v2 + 1]++;
+    }
+
+    /* Turns the degrees into slice offsets */
+    for(int i = 0; i < numVertices; i++)
+        graph.offsets[i + 1] += graph.offsets[i];
+
+    /* Scatters the edges into both endpoints' slices */
+    int* fill = new int[numVertices];
+    for(int i = 0; i < numVertices; i++)
+        fill[i] = graph.offsets[i];
+
+    for(int j = 0; j < numEdges; j++) {
+        int k1 = fill[E[j].v1]++;
+        int k2 = fill[E[j].v2]++;
+
+        graph.neighbors[k1] = E[j].v2;
+        graph.weights[k1] = E[j].w;
+        graph.edgeIds[k1] = j;
+
+        graph.neighbors[k2] = E[j].v1;
+        graph.weights[k2] = E[j].w;
+        graph.edgeIds[k2] = j;
+    }
+
+    delete [] fill;
+    return graph;
+}
+
+/* Releases the arrays of a CSR graph */
+inline void freeCSR(CSR_Graph &graph) {
+    delete [] graph.offsets;
+    delete [] graph.neighbors;
+    delete [] graph.weights;
+    delete [] graph.edgeIds;
+
+    graph.offsets = graph.neighbors = graph.weights = graph.edgeIds = NULL;
+}
+
+#endif
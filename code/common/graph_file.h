@@ -0,0 +1,333 @@
+/* graph_file.h
+*
+*  Binary graph file, laid out so that it can be mmap'ed and handed to
+*  the engines as is: a fixed header, then one section per array, every
+*  section starting on a 64-byte boundary.
+*
+*  edges => the edge list, v1 < v2 - what the engines take as input;
+*           graph_convert writes it sorted by (v1, v2)
+*  offsets, neighbors, weights => its CSR form (graph.h)
+*  edgeIds => optional, the edge of every adjacency entry
+*
+*  Loading maps the file read-only and checks the header and the ends of
+*  the offsets - a few pages - so nothing is parsed or copied: a graph of
+*  any size loads in about the time of the mmap call, and processes
+*  reading the same file share its pages in the page cache. The full
+*  check of every index (checkGraphArrays) reads the whole file, it runs
+*  on request only (--verify). The arrays are in the byte order of the
+*  machine that wrote them; the header magic tells a file of the other
+*  order.
+*
+*/
+
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+#include "csr_build.h"
+
+/* Magic and version of the format */
+#define GRAPH_FILE_MAGIC 0x3146474d54534d42ULL     /* "BMSTMGF1" */
+#define GRAPH_FILE_VERSION 1
+
+/* Alignment of every section */
+#define GRAPH_FILE_ALIGNMENT 64
+
+/* Buffer of the writer */
+#define GRAPH_FILE_BUFFER (8 * 1024 * 1024)
+
+/* Flags of the header */
+#define GRAPH_FILE_EDGE_IDS 1U
+
+/* Sections of the file, in the order they are written */
+enum Graph_Section {
+    SECTION_EDGES,
+    SECTION_OFFSETS,
+    SECTION_NEIGHBORS,
+    SECTION_WEIGHTS,
+    SECTION_EDGE_IDS,
+    NUM_GRAPH_SECTIONS
+};
+
+/* Outcomes of reading or writing a graph file */
+enum Graph_File_Status {
+    GRAPH_FILE_OK,
+    GRAPH_FILE_OPEN,
+    GRAPH_FILE_MAGIC_MISMATCH,
+    GRAPH_FILE_VERSION_MISMATCH,
+    GRAPH_FILE_CORRUPT,
+    GRAPH_FILE_TOO_LARGE,
+    GRAPH_FILE_WRITE,
+    NUM_GRAPH_FILE_STATUSES
+};
+
+const char* const graphFileStatusNames[NUM_GRAPH_FILE_STATUSES] = {
+    "ok", "can't open or map the file", "not a graph file (or of the other byte order)",
+    "unsupported version of the format",
+    "sections out of the file or inconsistent, or indices out of range",
+    "graph too large for int indices", "error writing the file"
+};
+
+/* struct(ure) Graph_File_Header opens the file
+*
+*  magic, version => GRAPH_FILE_MAGIC, GRAPH_FILE_VERSION
+*  flags => GRAPH_FILE_EDGE_IDS if the edgeIds section is there
+*  numVertices, numEdges => size of the graph, 64-bit for later versions
+*  sections => byte offset of every section, 0 if it's absent
+*  fileSize => size of the whole file, catches truncated copies
+*/
+struct Graph_File_Header {
+    uint64_t magic;
+    uint32_t version
+    ,        flags;
+    int64_t numVertices
+    ,       numEdges;
+    uint64_t sections[NUM_GRAPH_SECTIONS];
+    uint64_t fileSize;
+};
+
+/* struct(ure) Mapped_Graph holds a graph file mapped into memory
+*
+*  edges => the edge list, straight in the (read-only) mapping
+*  csr => its CSR form, also in the mapping; edgeIds is NULL if the file
+*         has none
+*/
+struct Mapped_Graph {
+    void* base;
+    size_t bytes;
+    int numVertices
+    ,   numEdges;
+    Edge* edges;
+    CSR_Graph csr;
+};
+
+/* Bytes of a section of a graph with numVertices and numEdges */
+inline uint64_t sectionBytes(Graph_Section section, uint64_t numVertices, uint64_t numEdges) {
+    if (section == SECTION_EDGES) return numEdges * sizeof(Edge);
+    if (section == SECTION_OFFSETS) return (numVertices + 1) * sizeof(int);
+    return 2 * numEdges * sizeof(int);
+}
+
+/* Rounds a byte offset up to the next section boundary */
+inline uint64_t alignSection(uint64_t offset) {
+    return (offset + GRAPH_FILE_ALIGNMENT - 1) / GRAPH_FILE_ALIGNMENT * GRAPH_FILE_ALIGNMENT;
+}
+
+/* Writes an edge list and its CSR form to a graph file
+*
+*  E => edges with v1 < v2, below numVertices
+*  edgeIds => also writes the edge of every adjacency entry
+*/
+inline Graph_File_Status writeGraphFile(const char* path, Edge* E, int numEdges, int numVertices,
+                                        bool edgeIds, int numThreads) {
+    /* The CSR holds every edge twice, in int offsets */
+    if (numEdges > INT_MAX / 2) return GRAPH_FILE_TOO_LARGE;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return GRAPH_FILE_OPEN;
+
+    setvbuf(file, NULL, _IOFBF, GRAPH_FILE_BUFFER);
+
+    CSR_Graph graph = buildCSR(E, numEdges, numVertices, numThreads);
+    const void* arrays[NUM_GRAPH_SECTIONS] = {
+        E, graph.offsets, graph.neighbors, graph.weights, graph.edgeIds
+    };
+    Graph_File_Header header;
+    uint64_t offset = alignSection(sizeof(Graph_File_Header));
+
+    memset(&header, 0, sizeof(header));
+    header.magic = GRAPH_FILE_MAGIC;
+    header.version = GRAPH_FILE_VERSION;
+    header.flags = edgeIds ? GRAPH_FILE_EDGE_IDS : 0;
+    header.numVertices = numVertices;
+    header.numEdges = numEdges;
+
+    for(int s = 0; s < NUM_GRAPH_SECTIONS; s++) {
+        if (s == SECTION_EDGE_IDS && !edgeIds) continue;
+
+        header.sections[s] = offset;
+        offset = alignSection(offset + sectionBytes((Graph_Section) s, numVertices, numEdges));
+    }
+    header.fileSize = offset;
+
+    /* Header, then every section after its padding */
+    static const char padding[GRAPH_FILE_ALIGNMENT] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+
+    for(int s = 0; s < NUM_GRAPH_SECTIONS && ok; s++) {
+        if (header.sections[s] == 0) continue;
+
+        uint64_t bytes = sectionBytes((Graph_Section) s, numVertices, numEdges);
+
+        ok = fwrite(padding, 1, header.sections[s] - written, file) == header.sections[s] - written
+          && fwrite(arrays[s], 1, bytes, file) == bytes;
+        written = header.sections[s] + bytes;
+    }
+    ok = ok && fwrite(padding, 1, header.fileSize - written, file) == header.fileSize - written;
+
+    ok = fclose(file) == 0 && ok;
+    freeCSR(graph);
+
+    return ok ? GRAPH_FILE_OK : GRAPH_FILE_WRITE;
+}
+
+/* Checks the header of a mapping of bytes bytes */
+inline Graph_File_Status checkGraphHeader(const Graph_File_Header* header, size_t bytes) {
+    if (bytes < sizeof(Graph_File_Header) || header->magic != GRAPH_FILE_MAGIC)
+        return GRAPH_FILE_MAGIC_MISMATCH;
+    if (header->version != GRAPH_FILE_VERSION) return GRAPH_FILE_VERSION_MISMATCH;
+    if (header->fileSize != bytes || header->numVertices < 0 || header->numEdges < 0)
+        return GRAPH_FILE_CORRUPT;
+    if (header->numVertices > INT_MAX - 1 || header->numEdges > INT_MAX / 2)
+        return GRAPH_FILE_TOO_LARGE;
+
+    for(int s = 0; s < NUM_GRAPH_SECTIONS; s++) {
+        uint64_t offset = header->sections[s];
+        bool wanted = s != SECTION_EDGE_IDS || (header->flags & GRAPH_FILE_EDGE_IDS);
+
+        if (!wanted) {
+            if (offset != 0) return GRAPH_FILE_CORRUPT;
+            continue;
+        }
+        if (offset < sizeof(Graph_File_Header) || offset % GRAPH_FILE_ALIGNMENT != 0
+            || offset > bytes || sectionBytes((Graph_Section) s, header->numVertices,
+                                              header->numEdges) > bytes - offset)
+            return GRAPH_FILE_CORRUPT;
+    }
+
+    return GRAPH_FILE_OK;
+}
+
+/* Unmaps a graph file; its arrays are gone afterwards */
+inline void unmapGraphFile(Mapped_Graph &graph) {
+#ifdef __linux__
+    if (graph.base != NULL)
+        munmap(graph.base, graph.bytes);
+#endif
+
+    memset(&graph, 0, sizeof(graph));
+}
+
+/* Number of values of array [0, n) outside [low, high) */
+inline int countOutOfRange(const int* array, int n, int low, int high, int numThreads) {
+    return parallelReduce<int>(n, numThreads, 0, [&](int begin, int end) {
+        int count = 0;
+
+        for(int i = begin; i < end; i++)
+            count += array[i] < low || array[i] >= high;
+        return count;
+    }, [](int a, int b) { return a + b; });
+}
+
+/* Checks every array of a mapped graph, in one parallel pass over the
+*  whole file, so that no engine indexes out of them: offsets that never
+*  go down, endpoints and neighbors below numVertices, edge ids below
+*  numEdges
+*/
+inline Graph_File_Status checkGraphArrays(const Mapped_Graph &graph, int numThreads) {
+    const CSR_Graph &csr = graph.csr;
+    int entries = 2 * graph.numEdges;
+    int bad = parallelReduce<int>(graph.numVertices, numThreads, 0, [&](int begin, int end) {
+        int count = 0;
+
+        for(int v = begin; v < end; v++)
+            count += csr.offsets[v] > csr.offsets[v + 1];
+        return count;
+    }, [](int a, int b) { return a + b; });
+
+    bad += parallelReduce<int>(graph.numEdges, numThreads, 0, [&](int begin, int end) {
+        int count = 0;
+
+        for(int i = begin; i < end; i++) {
+            const Edge &edge = graph.edges[i];
+
+            count += edge.v1 < 0 || edge.v1 >= graph.numVertices
+                  || edge.v2 < 0 || edge.v2 >= graph.numVertices;
+        }
+        return count;
+    }, [](int a, int b) { return a + b; });
+    bad += countOutOfRange(csr.neighbors, entries, 0, graph.numVertices, numThreads);
+    if (csr.edgeIds != NULL)
+        bad += countOutOfRange(csr.edgeIds, entries, 0, graph.numEdges, numThreads);
+
+    return bad == 0 ? GRAPH_FILE_OK : GRAPH_FILE_CORRUPT;
+}
+
+/* Maps a graph file read-only - its arrays are used in place
+*
+*  graph => the mapped graph, released with unmapGraphFile
+*/
+inline Graph_File_Status mapGraphFile(const char* path, Mapped_Graph &graph) {
+    memset(&graph, 0, sizeof(graph));
+
+#ifdef __linux__
+    int fd = open(path, O_RDONLY);
+    struct stat status;
+
+    if (fd < 0) return GRAPH_FILE_OPEN;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return GRAPH_FILE_OPEN;
+    }
+    if (status.st_size < (off_t) sizeof(Graph_File_Header)) {
+        close(fd);
+        return GRAPH_FILE_MAGIC_MISMATCH;
+    }
+
+    size_t bytes = (size_t) status.st_size;
+    void* base = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+
+    /* The mapping holds its own reference to the file */
+    close(fd);
+    if (base == MAP_FAILED) return GRAPH_FILE_OPEN;
+
+    const Graph_File_Header* header = (const Graph_File_Header*) base;
+    Graph_File_Status result = checkGraphHeader(header, bytes);
+
+    if (result != GRAPH_FILE_OK) {
+        munmap(base, bytes);
+        return result;
+    }
+
+    const char* data = (const char*) base;
+
+    graph.base = base;
+    graph.bytes = bytes;
+    graph.numVertices = (int) header->numVertices;
+    graph.numEdges = (int) header->numEdges;
+    graph.edges = (Edge*) (data + header->sections[SECTION_EDGES]);
+    graph.csr.numVertices = graph.numVertices;
+    graph.csr.numEdges = graph.numEdges;
+    graph.csr.offsets = (int*) (data + header->sections[SECTION_OFFSETS]);
+    graph.csr.neighbors = (int*) (data + header->sections[SECTION_NEIGHBORS]);
+    graph.csr.weights = (int*) (data + header->sections[SECTION_WEIGHTS]);
+    graph.csr.edgeIds = header->sections[SECTION_EDGE_IDS] != 0
+                      ? (int*) (data + header->sections[SECTION_EDGE_IDS]) : NULL;
+
+    /* The CSR spans exactly the 2 * numEdges entries */
+    if (graph.csr.offsets[0] != 0 || graph.csr.offsets[graph.numVertices] != 2 * graph.numEdges) {
+        unmapGraphFile(graph);
+        return GRAPH_FILE_CORRUPT;
+    }
+
+    return GRAPH_FILE_OK;
+#else
+    (void) path;
+    return GRAPH_FILE_OPEN;
+#endif
+}
+
+#endif
@@ -0,0 +1,232 @@
+/* isa_dispatch.h
+*
+*  Runtime CPU dispatch of the host hot loops. Every loop is built for
+*  several ISA targets in the same binary (function multiversioning with
+*  target attributes) and a dispatch table picks one set of versions at
+*  startup - the widest the CPU supports, or the one asked for with
+*  selectIsa (e.g. from a --isa option, for benchmarking).
+*
+*  min-edge scan => argmin of an adjacency slice (min_edge_simd.h)
+*  live count => edges of a chunk crossing two components (compaction)
+*  int sum => chunk totals of the host scan
+*  weight sum, weight range => reductions over edge weights
+*  row min, row relax => scans of adjacency matrix rows (dense engine)
+*
+*/
+
+#ifndef ISA_DISPATCH_H
+#define ISA_DISPATCH_H
+
+#include <cstddef>
+#include <climits>
+#include <cstring>
+
+#include "graph.h"
+#include "min_edge_simd.h"
+
+/* Instruction sets the hot loops are built for */
+enum Isa_Level {
+    ISA_SCALAR,
+    ISA_AVX2,
+    ISA_AVX512,
+    NUM_ISA_LEVELS
+};
+
+const char* const isaNames[NUM_ISA_LEVELS] = { "scalar", "avx2", "avx512" };
+
+/* struct(ure) Isa_Dispatch holds one version of every hot loop
+*
+*  level => instruction set the versions are built for
+*/
+struct Isa_Dispatch {
+    Isa_Level level;
+    Min_Edge_Scan minEdgeScan;
+    int (*countLiveEdges)(const Edge* E, const int* comp, int first, int last);
+    int (*sumInts)(const int* values, size_t n);
+    long long (*sumWeights)(const Edge* E, int n);
+    void (*weightRange)(const Edge* E, int n, int* minWeight, int* maxWeight);
+    int (*rowMin)(const int* row, int n);
+    void (*relaxRow)(const int* row, int n, const int* inTree, int* key, int* from, int u);
+};
+
+/* Bodies of the loops - inlined into every target version below, where
+*  the compiler vectorizes them for that target
+*/
+#define ISA_INLINE inline __attribute__((always_inline))
+
+ISA_INLINE int countLiveEdgesBody(const Edge* E, const int* comp, int first, int last) {
+    int count = 0;
+
+    for(int i = first; i < last; i++)
+        count += comp[E[i].v1] != comp[E[i].v2];
+
+    return count;
+}
+
+ISA_INLINE int sumIntsBody(const int* values, size_t n) {
+    int sum = 0;
+
+    for(size_t i = 0; i < n; i++)
+        sum += values[i];
+
+    return sum;
+}
+
+ISA_INLINE long long sumWeightsBody(const Edge* E, int n) {
+    long long sum = 0;
+
+    for(int i = 0; i < n; i++)
+        sum += E[i].w;
+
+    return sum;
+}
+
+ISA_INLINE void weightRangeBody(const Edge* E, int n, int* minWeight, int* maxWeight) {
+    int lo = INT_MAX
+    ,   hi = INT_MIN;
+
+    for(int i = 0; i < n; i++) {
+        lo = E[i].w < lo ? E[i].w : lo;
+        hi = E[i].w > hi ? E[i].w : hi;
+    }
+
+    *minWeight = n > 0 ? lo : 0;
+    *maxWeight = n > 0 ? hi : 0;
+}
+
+/* Column of the lightest edge of a matrix row (weights above 0 are
+*  edges), ties go to the smaller column - -1 if the row has no edge
+*/
+ISA_INLINE int rowMinBody(const int* row, int n) {
+    int minWeight = INT_MAX
+    ,   column = INT_MAX;
+
+    for(int v = 0; v < n; v++) {
+        int w = row[v] > 0 ? row[v] : INT_MAX;
+        minWeight = w < minWeight ? w : minWeight;
+    }
+
+    if (minWeight == INT_MAX) return -1;
+
+    for(int v = 0; v < n; v++) {
+        int c = row[v] == minWeight ? v : INT_MAX;
+        column = c < column ? c : column;
+    }
+
+    return column;
+}
+
+/* Prim relaxation along the matrix row of vertex u: every vertex not in
+*  the tree yet gets its key lowered to its edge from u, if lighter
+*/
+ISA_INLINE void relaxRowBody(const int* row, int n, const int* inTree, int* key, int* from,
+                             int u) {
+    for(int v = 0; v < n; v++) {
+        int w = row[v] > 0 ? row[v] : INT_MAX;
+        bool lighter = (inTree[v] == 0) & (w < key[v]);
+
+        key[v] = lighter ? w : key[v];
+        from[v] = lighter ? u : from[v];
+    }
+}
+
+/* Builds the versions of every loop for one target */
+#define DEFINE_ISA_VERSIONS(SUFFIX, TARGET)                                                   \
+    TARGET inline int countLiveEdges##SUFFIX(const Edge* E, const int* comp, int first,      \
+                                             int last) {                                     \
+        return countLiveEdgesBody(E, comp, first, last);                                     \
+    }                                                                                        \
+    TARGET inline int sumInts##SUFFIX(const int* values, size_t n) {                         \
+        return sumIntsBody(values, n);                                                       \
+    }                                                                                        \
+    TARGET inline long long sumWeights##SUFFIX(const Edge* E, int n) {                       \
+        return sumWeightsBody(E, n);                                                         \
+    }                                                                                        \
+    TARGET inline void weightRange##SUFFIX(const Edge* E, int n, int* minWeight,             \
+                                           int* maxWeight) {                                 \
+        weightRangeBody(E, n, minWeight, maxWeight);                                         \
+    }                                                                                        \
+    TARGET inline int rowMin##SUFFIX(const int* row, int n) {                                \
+        return rowMinBody(row, n);                                                           \
+    }                                                                                        \
+    TARGET inline void relaxRow##SUFFIX(const int* row, int n, const int* inTree, int* key,  \
+                                        int* from, int u) {                                  \
+        relaxRowBody(row, n, inTree, key, from, u);                                          \
+    }
+
+DEFINE_ISA_VERSIONS(Scalar, )
+
+#ifdef HAVE_X86_SIMD
+DEFINE_ISA_VERSIONS(AVX2, __attribute__((target("avx2"))))
+DEFINE_ISA_VERSIONS(AVX512, __attribute__((target("avx512f"))))
+#endif
+
+/* Whether the CPU can run the given instruction set */
+inline bool isaSupported(Isa_Level level) {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (level == ISA_AVX512) return __builtin_cpu_supports("avx512f");
+    if (level == ISA_AVX2) return __builtin_cpu_supports("avx2");
+#endif
+
+    return level == ISA_SCALAR;
+}
+
+/* Dispatch table of one instruction set */
+inline Isa_Dispatch isaTable(Isa_Level level) {
+    Isa_Dispatch table = { ISA_SCALAR, minEdgeScalar, countLiveEdgesScalar, sumIntsScalar,
+                           sumWeightsScalar, weightRangeScalar, rowMinScalar, relaxRowScalar };
+
+#ifdef HAVE_X86_SIMD
+    if (level == ISA_AVX2) {
+        Isa_Dispatch avx2 = { ISA_AVX2, minEdgeAVX2, countLiveEdgesAVX2, sumIntsAVX2,
+                              sumWeightsAVX2, weightRangeAVX2, rowMinAVX2, relaxRowAVX2 };
+        table = avx2;
+    } else if (level == ISA_AVX512) {
+        Isa_Dispatch avx512 = { ISA_AVX512, minEdgeAVX512, countLiveEdgesAVX512, sumIntsAVX512,
+                                sumWeightsAVX512, weightRangeAVX512, rowMinAVX512,
+                                relaxRowAVX512 };
+        table = avx512;
+    }
+#endif
+
+    return table;
+}
+
+/* Widest instruction set the CPU supports */
+inline Isa_Level detectIsa() {
+    for (int level = NUM_ISA_LEVELS - 1; level > ISA_SCALAR; level--)
+        if (isaSupported((Isa_Level) level)) return (Isa_Level) level;
+
+    return ISA_SCALAR;
+}
+
+/* The dispatch table in use, set up on first use */
+inline Isa_Dispatch &isa() {
+    static Isa_Dispatch table = isaTable(detectIsa());
+
+    return table;
+}
+
+/* Switches the dispatch table to the named instruction set
+*
+*  returns false if the name is unknown or the CPU can't run it
+*/
+inline bool selectIsa(const char* name) {
+    for (int level = 0; level < NUM_ISA_LEVELS; level++) {
+        if (strcmp(name, isaNames[level]) != 0) continue;
+        if (!isaSupported((Isa_Level) level)) return false;
+
+        isa() = isaTable((Isa_Level) level);
+        return true;
+    }
+
+    return false;
+}
+
+/* Minimum edge index of a slice, -1 if the slice is empty */
+inline int minEdgeInSlice(const int* weights, const int* edgeIds, int n) {
+    return isa().minEdgeScan(weights, edgeIds, n);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/* matrix.h
+*
+*  Row-major int matrix in one contiguous block: the block and every row
+*  start on a 64-byte boundary (the row stride is padded to whole cache
+*  lines), so a row is one pointer add away, rows stream back to back
+*  and the whole matrix can be handed to OpenCL or written out in one
+*  piece. Large matrices can ask for huge pages to cut the TLB misses.
+*
+*/
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/* Alignment of the matrix block and its rows */
+#define MATRIX_ALIGNMENT 64
+
+/* Size of a (transparent) huge page */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* struct(ure) Dense_Matrix holds a row-major matrix
+*
+*  numRows, numCols => dimensions of the matrix
+*  stride => ints from the start of a row to the next one
+*  data => the block, numRows * stride ints
+*  bytes => size of the block
+*  mapped => the block is mmap'ed (huge pages) rather than allocated
+*/
+struct Dense_Matrix {
+    int numRows
+    ,   numCols
+    ,   stride;
+    int* data;
+    size_t bytes;
+    bool mapped;
+};
+
+/* Row stride (in ints) of an n-column matrix, padded to whole cache lines */
+inline int matrixStride(int n) {
+    int lanes = MATRIX_ALIGNMENT / sizeof(int);
+
+    return (n + lanes - 1) / lanes * lanes;
+}
+
+/* Maps a block backed by huge pages - explicit ones if the system has
+*  some reserved, transparent ones otherwise. NULL if mmap fails.
+*/
+inline int* mapHugePages(size_t bytes) {
+#ifdef __linux__
+    void* block = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    block = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (block == MAP_FAILED) {
+        block = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(block, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    return (int*) block;
+#else
+    (void) bytes;
+    return NULL;
+#endif
+}
+
+/* Creates a numRows x numCols matrix, its cells left uninitialized
+*
+*  hugePages => backs the block with huge pages where the system has
+*               them, plain aligned memory otherwise
+*  data is NULL if the block can't be allocated
+*/
+inline Dense_Matrix createMatrix(int numRows, int numCols, bool hugePages) {
+    Dense_Matrix matrix;
+
+    matrix.numRows = numRows;
+    matrix.numCols = numCols;
+    matrix.stride = matrixStride(numCols);
+    matrix.bytes = sizeof(int) * (size_t) numRows * matrix.stride;
+    matrix.data = NULL;
+    matrix.mapped = false;
+
+    if (hugePages) {
+        matrix.bytes = (matrix.bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        matrix.data = mapHugePages(matrix.bytes);
+        matrix.mapped = matrix.data != NULL;
+    }
+
+    if (matrix.data == NULL) {
+        void* block = NULL;
+
+        if (posix_memalign(&block, MATRIX_ALIGNMENT, matrix.bytes > 0 ? matrix.bytes : 1) == 0)
+            matrix.data = (int*) block;
+    }
+
+    return matrix;
+}
+
+/* Row i of the matrix */
+inline int* matrixRow(const Dense_Matrix &matrix, int i) {
+    return matrix.data + (size_t) i * matrix.stride;
+}
+
+/* Releases the block of a matrix */
+inline void freeMatrix(Dense_Matrix &matrix) {
+#ifdef __linux__
+    if (matrix.mapped)
+        munmap(matrix.data, matrix.bytes);
+    else
+#endif
+        free(matrix.data);
+
+    matrix.data = NULL;
+}
+
+#endif
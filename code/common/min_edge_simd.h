@@ -0,0 +1,128 @@
+/* min_edge_simd.h
+*
+*  Minimum edge of an adjacency slice given as separate (SoA) weight and
+*  edge index arrays, e.g. a CSR slice. Edges are ordered by weight, then
+*  by edge index, so every component agrees on one and the same minimum.
+*
+*  Besides the scalar loop there are AVX2 (8 lanes) and AVX-512 (16
+*  lanes) versions: the first pass finds the minimum weight, the second
+*  the smallest edge index carrying it. The one to use is picked at
+*  runtime by isa_dispatch.h.
+*
+*/
+
+#ifndef MIN_EDGE_SIMD_H
+#define MIN_EDGE_SIMD_H
+
+#include <climits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+/* GCC 12's AVX-512 intrinsics trip -Wmaybe-uninitialized (GCC PR 105593) */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+/* Signature of a slice scan: returns the minimum edge index, -1 if n is 0 */
+typedef int (*Min_Edge_Scan)(const int* weights, const int* edgeIds, int n);
+
+/* Scalar slice scan */
+inline int minEdgeScalar(const int* weights, const int* edgeIds, int n) {
+    int best = -1
+    ,   bestWeight = INT_MAX;
+
+    for(int k = 0; k < n; k++) {
+        if (best == -1 || weights[k] < bestWeight
+            || (weights[k] == bestWeight && edgeIds[k] < best)) {
+            best = edgeIds[k];
+            bestWeight = weights[k];
+        }
+    }
+
+    return best;
+}
+
+#ifdef HAVE_X86_SIMD
+
+/* AVX2 slice scan, 8 edges at a time */
+__attribute__((target("avx2")))
+inline int minEdgeAVX2(const int* weights, const int* edgeIds, int n) {
+    if (n <= 0) return -1;
+
+    int lanes[8]
+    ,   k = 0
+    ,   minWeight = INT_MAX
+    ,   best = INT_MAX;
+    __m256i vmin = _mm256_set1_epi32(INT_MAX);
+
+    for (; k + 8 <= n; k += 8)
+        vmin = _mm256_min_epi32(vmin, _mm256_loadu_si256((const __m256i*) (weights + k)));
+
+    _mm256_storeu_si256((__m256i*) lanes, vmin);
+    for(int l = 0; l < 8; l++)
+        if (lanes[l] < minWeight) minWeight = lanes[l];
+    for (; k < n; k++)
+        if (weights[k] < minWeight) minWeight = weights[k];
+
+    /* Smallest edge index among the lightest edges */
+    __m256i vweight = _mm256_set1_epi32(minWeight)
+    ,       none = _mm256_set1_epi32(INT_MAX)
+    ,       vbest = none;
+
+    for (k = 0; k + 8 <= n; k += 8) {
+        __m256i match = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (weights + k)), vweight);
+        __m256i ids = _mm256_loadu_si256((const __m256i*) (edgeIds + k));
+
+        vbest = _mm256_min_epi32(vbest, _mm256_blendv_epi8(none, ids, match));
+    }
+
+    _mm256_storeu_si256((__m256i*) lanes, vbest);
+    for(int l = 0; l < 8; l++)
+        if (lanes[l] < best) best = lanes[l];
+    for (; k < n; k++)
+        if (weights[k] == minWeight && edgeIds[k] < best) best = edgeIds[k];
+
+    return best;
+}
+
+/* AVX-512 slice scan, 16 edges at a time with a masked tail */
+__attribute__((target("avx512f")))
+inline int minEdgeAVX512(const int* weights, const int* edgeIds, int n) {
+    if (n <= 0) return -1;
+
+    int k = 0;
+    __m512i none = _mm512_set1_epi32(INT_MAX)
+    ,       vmin = none;
+
+    for (; k + 16 <= n; k += 16)
+        vmin = _mm512_min_epi32(vmin, _mm512_loadu_si512(weights + k));
+    if (k < n) {
+        __mmask16 tail = (__mmask16) ((1u << (n - k)) - 1);
+        vmin = _mm512_min_epi32(vmin, _mm512_mask_loadu_epi32(none, tail, weights + k));
+    }
+
+    int minWeight = _mm512_reduce_min_epi32(vmin);
+
+    /* Smallest edge index among the lightest edges */
+    __m512i vweight = _mm512_set1_epi32(minWeight)
+    ,       vbest = none;
+
+    for (k = 0; k + 16 <= n; k += 16) {
+        __mmask16 match = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(weights + k), vweight);
+        vbest = _mm512_mask_min_epi32(vbest, match, vbest, _mm512_loadu_si512(edgeIds + k));
+    }
+    if (k < n) {
+        __mmask16 tail = (__mmask16) ((1u << (n - k)) - 1);
+        __mmask16 match = _mm512_mask_cmpeq_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, weights + k),
+                                                       vweight);
+        vbest = _mm512_mask_min_epi32(vbest, match, vbest, _mm512_maskz_loadu_epi32(tail, edgeIds + k));
+    }
+
+    return _mm512_reduce_min_epi32(vbest);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,319 @@
+/* mst_writer.h
+*
+*  Output of the MST edges, to a file or stdout. The edges are cut into
+*  chunks formatted in parallel into one large buffer, then written in
+*  order with one fwrite per chunk; while a batch of chunks is written on
+*  its own thread, the pool formats the next one into a second buffer.
+*
+*  text => one "v1 v2 w" line per edge - a SNAP edge list, so the tree
+*          can be read back with --input
+*  binary => the binary graph file of graph_file.h
+*  delta => the edges sorted by key v1 * V + v2 (v1 < v2), every key as
+*           the varint of its gap to the previous one followed by the
+*           zigzag varint of the weight, after an MST_Delta_Header
+*  none => nothing is written
+*
+*/
+
+#ifndef MST_WRITER_H
+#define MST_WRITER_H
+
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <thread>
+
+#include "graph.h"
+#include "parallel.h"
+#include "radix_sort.h"
+#include "isa_dispatch.h"
+#include "graph_file.h"
+
+/* Magic of the delta format */
+#define MST_DELTA_MAGIC 0x31544c4454534d42ULL     /* "BMSTDLT1" */
+
+/* Edges of a chunk and chunks of a batch */
+#define MST_OUTPUT_CHUNK 16384
+#define MST_OUTPUT_BATCH 64
+
+/* Largest size of one edge: a text line, or a 64-bit gap and a weight */
+#define MST_TEXT_EDGE_BYTES 36
+#define MST_DELTA_EDGE_BYTES 16
+
+/* Formats of the MST output */
+enum Output_Format {
+    OUTPUT_TEXT,
+    OUTPUT_BINARY,
+    OUTPUT_DELTA,
+    OUTPUT_NONE,
+    NUM_OUTPUT_FORMATS
+};
+
+const char* const outputFormatNames[NUM_OUTPUT_FORMATS] = { "text", "binary", "delta", "none" };
+
+/* Outcomes of writing the MST */
+enum Output_Status {
+    OUTPUT_OK,
+    OUTPUT_OPEN,
+    OUTPUT_WRITE,
+    OUTPUT_BINARY_STDOUT,
+    NUM_OUTPUT_STATUSES
+};
+
+const char* const outputStatusNames[NUM_OUTPUT_STATUSES] = {
+    "ok", "can't open the file", "error writing the output",
+    "the binary format needs an --output file"
+};
+
+/* struct(ure) Output_Options says where and how the MST goes
+*
+*  format => one of Output_Format
+*  path => file to write, NULL or "-" for stdout
+*/
+struct Output_Options {
+    Output_Format format;
+    const char* path;
+};
+
+/* struct(ure) MST_Delta_Header opens a delta file
+*
+*  magic => MST_DELTA_MAGIC
+*  numVertices => V of the keys v1 * V + v2
+*  numEdges => number of MST edges that follow
+*/
+struct MST_Delta_Header {
+    uint64_t magic;
+    int64_t numVertices
+    ,       numEdges;
+};
+
+/* Text to stdout */
+inline Output_Options defaultOutputOptions() {
+    Output_Options options;
+
+    options.format = OUTPUT_TEXT;
+    options.path = NULL;
+    return options;
+}
+
+/* True if the output goes to stdout */
+inline bool outputToStdout(const Output_Options &options) {
+    return options.path == NULL || strcmp(options.path, "-") == 0;
+}
+
+/* Parses one output option of the command line at argv[i]
+*
+*  --output FILE => file of the MST, - for stdout
+*  --output-format text|binary|delta|none => format of the MST
+*
+*  returns false if argv[i] isn't a (valid) output option, otherwise
+*  leaves i on its last argument
+*/
+inline bool parseOutputOption(int argc, char** argv, int &i, Output_Options &options) {
+    if (i + 1 >= argc) return false;
+
+    if (strcmp(argv[i], "--output") == 0) {
+        options.path = argv[i + 1];
+    } else if (strcmp(argv[i], "--output-format") == 0) {
+        int k = 0;
+
+        while (k < NUM_OUTPUT_FORMATS && strcmp(argv[i + 1], outputFormatNames[k]) != 0) k++;
+        if (k == NUM_OUTPUT_FORMATS) return false;
+        options.format = (Output_Format) k;
+    } else {
+        return false;
+    }
+
+    i++;
+    return true;
+}
+
+/* Two decimal digits of every value below 100 */
+const char mstDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Writes value in decimal at out, returns the end of it */
+inline char* formatUnsigned(char* out, uint32_t value) {
+    char digits[10];
+    int k = 10;
+
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+
+        value /= 100;
+        digits[--k] = mstDigitPairs[pair + 1];
+        digits[--k] = mstDigitPairs[pair];
+    }
+    if (value >= 10) {
+        digits[--k] = mstDigitPairs[value * 2 + 1];
+        digits[--k] = mstDigitPairs[value * 2];
+    } else {
+        digits[--k] = (char) ('0' + value);
+    }
+
+    memcpy(out, digits + k, 10 - k);
+    return out + 10 - k;
+}
+
+inline char* formatInteger(char* out, int value) {
+    if (value >= 0) return formatUnsigned(out, (uint32_t) value);
+
+    *out = '-';
+    return formatUnsigned(out + 1, 0u - (uint32_t) value);
+}
+
+/* Writes value as a LEB128 varint at out, returns the end of it */
+inline char* encodeVarint(char* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (char) (value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (char) value;
+    return out;
+}
+
+/* Text lines of the edges [first, last) */
+inline char* formatTextChunk(char* out, const Edge* E, int first, int last) {
+    for(int i = first; i < last; i++) {
+        out = formatUnsigned(out, (uint32_t) E[i].v1);
+        *out++ = ' ';
+        out = formatUnsigned(out, (uint32_t) E[i].v2);
+        *out++ = ' ';
+        out = formatInteger(out, E[i].w);
+        *out++ = '\n';
+    }
+    return out;
+}
+
+/* Delta records of the sorted edges [first, last) */
+inline char* formatDeltaChunk(char* out, const Edge* E, int first, int last, int numVertices) {
+    uint64_t previous = first > 0 ? (uint64_t) E[first - 1].v1 * numVertices + E[first - 1].v2 : 0;
+
+    for(int i = first; i < last; i++) {
+        uint64_t key = (uint64_t) E[i].v1 * numVertices + E[i].v2;
+        uint32_t weight = ((uint32_t) E[i].w << 1) ^ (uint32_t) (E[i].w >> 31);
+
+        out = encodeVarint(out, key - previous);
+        out = encodeVarint(out, weight);
+        previous = key;
+    }
+    return out;
+}
+
+/* Formats and writes the edges of E in batches of chunks, the write of a
+*  batch overlapping the formatting of the next one
+*/
+inline bool writeMSTChunks(FILE* file, const Edge* E, int count, int numVertices, bool delta,
+                           int numThreads) {
+    int edgeBytes = delta ? MST_DELTA_EDGE_BYTES : MST_TEXT_EDGE_BYTES;
+    int numChunks = (count + MST_OUTPUT_CHUNK - 1) / MST_OUTPUT_CHUNK;
+    int batchChunks = numChunks < MST_OUTPUT_BATCH ? numChunks : MST_OUTPUT_BATCH;
+    size_t chunkBytes = (size_t) MST_OUTPUT_CHUNK * edgeBytes;
+    char* buffers[2] = {
+        new char[batchChunks * chunkBytes + 1], new char[batchChunks * chunkBytes + 1]
+    };
+    size_t* lengths[2] = { new size_t[batchChunks + 1], new size_t[batchChunks + 1] };
+    std::thread writer;
+    bool ok = true;
+
+    for(int batch = 0, b = 0; batch < numChunks; batch += batchChunks, b ^= 1) {
+        int chunks = numChunks - batch < batchChunks ? numChunks - batch : batchChunks;
+        char* buffer = buffers[b];
+        size_t* length = lengths[b];
+
+        parallelFor(chunks, numThreads, [&](int begin, int end) {
+            for(int c = begin; c < end; c++) {
+                int first = (batch + c) * MST_OUTPUT_CHUNK
+                ,   last = first + MST_OUTPUT_CHUNK < count ? first + MST_OUTPUT_CHUNK : count;
+                char* out = buffer + c * chunkBytes;
+                char* stop = delta ? formatDeltaChunk(out, E, first, last, numVertices)
+                                   : formatTextChunk(out, E, first, last);
+
+                length[c] = stop - out;
+            }
+        });
+
+        /* The previous batch has to be out before this one goes */
+        if (writer.joinable()) writer.join();
+        writer = std::thread([=, &ok]() {
+            for(int c = 0; c < chunks && ok; c++)
+                ok = fwrite(buffer + c * chunkBytes, 1, length[c], file) == length[c];
+        });
+    }
+    if (writer.joinable()) writer.join();
+
+    for(int b = 0; b < 2; b++) {
+        delete [] buffers[b];
+        delete [] lengths[b];
+    }
+    return ok;
+}
+
+/* Writes the MST edges (v1 < v2) as options say
+*
+*  mst, count => the MST edges
+*  numVertices => number of vertices of the graph
+*/
+inline Output_Status writeMST(const Output_Options &options, const Edge* mst, int count,
+                              int numVertices, int numThreads) {
+    if (options.format == OUTPUT_NONE) return OUTPUT_OK;
+
+    bool toStdout = outputToStdout(options);
+
+    if (options.format == OUTPUT_BINARY) {
+        if (toStdout) return OUTPUT_BINARY_STDOUT;
+
+        Graph_File_Status status = writeGraphFile(options.path, (Edge*) mst, count, numVertices,
+                                                  true, numThreads);
+        if (status == GRAPH_FILE_OK) return OUTPUT_OK;
+        return status == GRAPH_FILE_OPEN ? OUTPUT_OPEN : OUTPUT_WRITE;
+    }
+
+    FILE* file = toStdout ? stdout : fopen(options.path, "wb");
+    if (file == NULL) return OUTPUT_OPEN;
+
+    bool ok = true;
+
+    if (options.format == OUTPUT_TEXT) {
+        ok = writeMSTChunks(file, mst, count, numVertices, false, numThreads);
+    } else {
+        /* Sorts a copy of the edges by key, the gaps are then positive */
+        Edge* E = new Edge[count > 0 ? count : 1];
+        Edge* tmpE = new Edge[count > 0 ? count : 1];
+        int* ids = new int[count > 0 ? count : 1];
+        int* tmpIds = new int[count > 0 ? count : 1];
+        int minWeight = 0
+        ,   maxWeight = 0;
+
+        parallelFor(count, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                E[i] = mst[i];
+                ids[i] = i;
+            }
+        });
+        if (count > 0) isa().weightRange(E, count, &minWeight, &maxWeight);
+        radixSortEdges(E, ids, count, numVertices, minWeight, maxWeight, tmpE, tmpIds,
+                       numThreads);
+
+        MST_Delta_Header header;
+
+        header.magic = MST_DELTA_MAGIC;
+        header.numVertices = numVertices;
+        header.numEdges = count;
+
+        ok = fwrite(&header, sizeof(header), 1, file) == 1
+          && writeMSTChunks(file, E, count, numVertices, true, numThreads);
+
+        delete [] E;
+        delete [] tmpE;
+        delete [] ids;
+        delete [] tmpIds;
+    }
+
+    ok = (toStdout ? fflush(file) : fclose(file)) == 0 && ok;
+    return ok ? OUTPUT_OK : OUTPUT_WRITE;
+}
+
+#endif
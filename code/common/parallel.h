@@ -0,0 +1,112 @@
+/* parallel.h
+*
+*  Host-side parallel loops, run on a process-wide work-stealing pool
+*  (thread_pool.h) that starts on first use.
+*
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+/* Number of hardware threads available - at least 1 */
+inline int hardwareThreads() {
+    unsigned int n = std::thread::hardware_concurrency();
+
+    return n > 0 ? (int) n : 1;
+}
+
+/* struct(ure) Host_Pool owns the process-wide pool, stopped at exit */
+struct Host_Pool {
+    Thread_Pool* pool;
+
+    ~Host_Pool() {
+        if (pool != NULL) {
+            StopPool(*pool);
+            delete pool;
+        }
+    }
+};
+
+inline Host_Pool &hostPoolHolder() {
+    static Host_Pool holder = { NULL };
+
+    return holder;
+}
+
+/* (Re)starts the process-wide pool
+*
+*  numThreads => workers including the calling thread
+*  pin => pins worker i to core i
+*/
+inline void configureHostPool(int numThreads, bool pin) {
+    Host_Pool &holder = hostPoolHolder();
+
+    if (holder.pool != NULL) {
+        StopPool(*holder.pool);
+        delete holder.pool;
+    }
+
+    holder.pool = new Thread_Pool();
+    StartPool(*holder.pool, numThreads, pin);
+}
+
+/* The process-wide pool, sized from the hardware unless configured */
+inline Thread_Pool &hostPool() {
+    if (hostPoolHolder().pool == NULL)
+        configureHostPool(hardwareThreads(), false);
+
+    return *hostPoolHolder().pool;
+}
+
+/* Runs body(begin, end) over pieces of [0, n) that together cover it
+*  exactly once - about 4 pieces per thread, balanced by work stealing
+*
+*  numThreads => parallelism wanted, 1 runs the whole range serially on
+*                the calling thread
+*/
+template <typename Body>
+void parallelFor(int n, int numThreads, Body body) {
+    if (numThreads > n) numThreads = n;
+    if (numThreads <= 1) {
+        if (n > 0) body(0, n);
+        return;
+    }
+
+    int pieces = 4 * numThreads;
+    PoolParallelFor(hostPool(), n, (n + pieces - 1) / pieces, body);
+}
+
+/* Reduces [0, n) in parallel: map(begin, end) reduces a chunk, the chunk
+*  results are combined in order, so the result doesn't depend on the
+*  schedule
+*/
+template <typename T, typename Map, typename Combine>
+T parallelReduce(int n, int numThreads, T identity, Map map, Combine combine) {
+    int chunks = 4 * (numThreads > 0 ? numThreads : 1);
+    if (chunks > n) chunks = n;
+    if (chunks <= 1) return n > 0 ? combine(identity, map(0, n)) : identity;
+
+    int chunk = (n + chunks - 1) / chunks;
+    std::vector<T> partial(chunks, identity);
+
+    parallelFor(chunks, numThreads, [&](int begin, int end) {
+        for(int k = begin; k < end; k++) {
+            int first = k * chunk, last = first + chunk < n ? first + chunk : n;
+
+            if (first < last) partial[k] = map(first, last);
+        }
+    });
+
+    T result = identity;
+    for(int k = 0; k < chunks; k++)
+        result = combine(result, partial[k]);
+
+    return result;
+}
+
+#endif
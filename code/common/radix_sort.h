@@ -0,0 +1,134 @@
+/* radix_sort.h
+*
+*  Multi-threaded LSD radix sort of an edge list by (v1, v2, weight),
+*  carrying the original edge indices along. Every pass is stable: each
+*  thread counts the digits of its chunk, the counts are scanned in
+*  (digit, thread) order and every thread scatters its chunk from there.
+*  Digits that are the same for every key in range are skipped.
+*
+*/
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "graph.h"
+#include "parallel.h"
+
+/* Digit width of a pass and the minimum number of edges per thread */
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MIN_CHUNK 16384
+
+/* Fields of an edge's sort key, least significant first */
+enum Sort_Field {
+    SORT_WEIGHT,
+    SORT_V2,
+    SORT_V1,
+    NUM_SORT_FIELDS
+};
+
+/* Unsigned key of one field - weights get their sign bit flipped, so
+*  negative weights sort first
+*/
+inline uint32_t edgeSortKey(const Edge &edge, int field) {
+    switch (field) {
+    case SORT_WEIGHT: return (uint32_t) edge.w ^ 0x80000000u;
+    case SORT_V2: return (uint32_t) edge.v2;
+    default: return (uint32_t) edge.v1;
+    }
+}
+
+/* Number of digits that can differ between keys in [lo, hi] - every bit
+*  above the highest one where lo and hi differ is shared by the range
+*/
+inline int significantDigits(uint32_t lo, uint32_t hi, int digitBits) {
+    uint32_t diff = lo ^ hi;
+    int bits = 0;
+
+    while (diff != 0) {
+        diff >>= 1;
+        bits++;
+    }
+
+    return (bits + digitBits - 1) / digitBits;
+}
+
+/* Sorts E (and ids alongside) by (v1, v2, weight), stable for equal keys
+*
+*  numVertices => bound of the endpoints
+*  minWeight, maxWeight => range of the weights
+*  tmpE, tmpIds => scratch of n elements, the buffers get swapped so
+*                  the sorted edges always end up in E / ids
+*/
+inline void radixSortEdges(Edge* &E, int* &ids, int n, int numVertices,
+                           int minWeight, int maxWeight, Edge* &tmpE, int* &tmpIds,
+                           int numThreads) {
+    if (numThreads > n / RADIX_MIN_CHUNK) numThreads = n / RADIX_MIN_CHUNK;
+    if (numThreads < 1) numThreads = 1;
+
+    int chunk = (n + numThreads - 1) / numThreads;
+    int maxLabel = numVertices > 0 ? numVertices - 1 : 0;
+    int digits[NUM_SORT_FIELDS];
+    std::vector<int> counts(RADIX_BUCKETS * numThreads);
+
+    digits[SORT_WEIGHT] = significantDigits((uint32_t) minWeight ^ 0x80000000u,
+                                            (uint32_t) maxWeight ^ 0x80000000u, RADIX_BITS);
+    digits[SORT_V2] = digits[SORT_V1] = significantDigits(0, maxLabel, RADIX_BITS);
+
+    for(int field = 0; field < NUM_SORT_FIELDS; field++) {
+        for(int d = 0; d < digits[field]; d++) {
+            int shift = d * RADIX_BITS;
+
+            /* Counts the digits of every chunk */
+            parallelFor(numThreads, numThreads, [&](int begin, int end) {
+                for(int t = begin; t < end; t++) {
+                    int first = t * chunk, last = first + chunk < n ? first + chunk : n;
+                    int local[RADIX_BUCKETS] = { 0 };
+
+                    for(int i = first; i < last; i++)
+                        local[(edgeSortKey(E[i], field) >> shift) & (RADIX_BUCKETS - 1)]++;
+                    for(int b = 0; b < RADIX_BUCKETS; b++)
+                        counts[b * numThreads + t] = local[b];
+                }
+            });
+
+            /* Offsets in (digit, thread) order keep the pass stable */
+            int running = 0;
+            for(size_t k = 0; k < counts.size(); k++) {
+                int count = counts[k];
+                counts[k] = running;
+                running += count;
+            }
+
+            /* Scatters every chunk from its offsets */
+            parallelFor(numThreads, numThreads, [&](int begin, int end) {
+                for(int t = begin; t < end; t++) {
+                    int first = t * chunk, last = first + chunk < n ? first + chunk : n;
+                    int local[RADIX_BUCKETS];
+
+                    for(int b = 0; b < RADIX_BUCKETS; b++)
+                        local[b] = counts[b * numThreads + t];
+
+                    for(int i = first; i < last; i++) {
+                        int pos = local[(edgeSortKey(E[i], field) >> shift) & (RADIX_BUCKETS - 1)]++;
+                        tmpE[pos] = E[i];
+                        tmpIds[pos] = ids[i];
+                    }
+                }
+            });
+
+            Edge* tempE = E;
+            E = tmpE;
+            tmpE = tempE;
+
+            int* tempIds = ids;
+            ids = tmpIds;
+            tmpIds = tempIds;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,951 @@
+/* random_graph.h
+*
+*  Parallel random graph generators that write the edge list directly,
+*  with no V x V matrix behind them:
+*
+*  gnp => G(n, p), every vertex pair is an edge with probability p. The
+*         pair index space is cut into fixed blocks, each one skipping
+*         from edge to edge with geometric gaps.
+*  gnm => G(n, m), m distinct pairs drawn uniformly: every draw is a
+*         rank among the pairs not taken yet, so each round fills all
+*         the missing edges; above half the pairs, the excluded ones
+*         are drawn instead and the rest is emitted
+*  rmat => R-MAT / Graph500 Kronecker graph with a power-law degree
+*          distribution: edgeFactor * V edges, each one dropped into the
+*          quadrants (a, b, c, d) of the adjacency matrix scale times;
+*          the vertex labels are then scrambled, so the hubs spread over
+*          the whole range. Self-loops and duplicates are dropped.
+*  grid2d, grid3d => road- and mesh-like grids, the vertices laid out row
+*                    by row on a square (cube) of side ceil(V^(1/2))
+*                    (ceil(V^(1/3))), every vertex joined to its next
+*                    neighbor along each axis: high diameter, many rounds
+*  geometric => random geometric graph, V random points of the unit
+*               square joined when at most radius apart
+*  knn => every one of V random points of the unit square joined to its
+*         k nearest neighbors
+*
+*  The matrix model is the programs' own V x V adjacency matrix, every
+*  cell a hash of the seed filled in by fillMatrixGraph.
+*
+*  The points are bucketed into square cells, so a vertex only looks at
+*  the cells around its own; the spatial models run in fixed blocks of
+*  vertices, counting the edges of every block first, then filling them.
+*
+*  Every random number comes from a counter-based SplitMix64 stream keyed
+*  by (seed, stream, counter), so a graph depends on its options only -
+*  not on the number of threads or the schedule. The edges come out with
+*  v1 < v2, sorted by (v1, v2), without parallel edges.
+*
+*/
+
+#ifndef RANDOM_GRAPH_H
+#define RANDOM_GRAPH_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <stdint.h>
+
+#include "graph.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "scan.h"
+#include "radix_sort.h"
+#include "compact.h"
+
+/* Pairs per block of the G(n, p) generator, and the most blocks */
+#define GNP_BLOCK_PAIRS (1 << 20)
+#define GNP_MAX_BLOCKS (1 << 22)
+
+/* Streams of the counter-based generator, one per use */
+#define STREAM_GNP 1ULL
+#define STREAM_GNM 2ULL
+#define STREAM_WEIGHT 3ULL
+#define STREAM_BACKBONE 4ULL
+#define STREAM_RMAT 5ULL
+#define STREAM_SCRAMBLE 6ULL
+#define STREAM_POINTS 7ULL
+
+/* Graph500 defaults of the R-MAT generator */
+#define RMAT_EDGE_FACTOR 16
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+#define RMAT_D 0.05
+
+/* Vertices per block of the spatial generators */
+#define SPATIAL_BLOCK_VERTICES 4096
+
+/* Default average degree of the geometric graph, and k of the kNN graph */
+#define GEOMETRIC_DEGREE 8
+#define KNN_NEIGHBORS 8
+
+/* Models of the random graph */
+enum Graph_Model {
+    GRAPH_MATRIX,       /* the program's own V x V adjacency matrix */
+    GRAPH_GNP,
+    GRAPH_GNM,
+    GRAPH_RMAT,
+    GRAPH_GRID2D,
+    GRAPH_GRID3D,
+    GRAPH_GEOMETRIC,
+    GRAPH_KNN,
+    NUM_GRAPH_MODELS
+};
+
+const char* const graphModelNames[NUM_GRAPH_MODELS] = {
+    "matrix", "gnp", "gnm", "rmat", "grid2d", "grid3d", "geometric", "knn"
+};
+
+/* Distributions of the edge weights, all within [1, maxWeight] */
+enum Weight_Distribution {
+    WEIGHTS_UNIFORM,
+    WEIGHTS_CONSTANT,   /* every edge weighs 1 - all ties */
+    WEIGHTS_EXPONENTIAL, /* mean maxWeight / 8, clamped - many light edges */
+    NUM_WEIGHT_DISTRIBUTIONS
+};
+
+const char* const weightDistributionNames[NUM_WEIGHT_DISTRIBUTIONS] = {
+    "uniform", "constant", "exponential"
+};
+
+/* struct(ure) Generator_Options holds what graph to generate
+*
+*  numEdges => edges wanted (gnm)
+*  probability => edge probability (gnp)
+*  edgeFactor => edges per vertex (rmat)
+*  quadrants => probabilities a, b, c, d of the matrix quadrants (rmat)
+*  radius => distance joining two points (geometric), 0 for the one
+*            giving an average degree of GEOMETRIC_DEGREE
+*  neighbors => k (knn)
+*  connected => adds a random spanning tree as backbone
+*  input => graph file read instead of a random graph, NULL for none
+*  verify => checks every index of a binary graph file once mapped
+*/
+struct Generator_Options {
+    Graph_Model model;
+    int numVertices;
+    long long numEdges;
+    double probability;
+    int edgeFactor;
+    double quadrants[4];
+    double radius;
+    int neighbors;
+    Weight_Distribution weights;
+    int maxWeight;
+    uint64_t seed;
+    bool connected;
+    const char* input;
+    bool verify;
+};
+
+/* Generator options of a program, its defaults for the matrix */
+inline Generator_Options defaultGeneratorOptions(int numVertices, int maxWeight, uint64_t seed) {
+    Generator_Options options = { GRAPH_MATRIX, numVertices, 0, 0.0, RMAT_EDGE_FACTOR,
+                                  { RMAT_A, RMAT_B, RMAT_C, RMAT_D }, 0.0, KNN_NEIGHBORS,
+                                  WEIGHTS_UNIFORM,
+                                  maxWeight, seed, false, NULL, false };
+
+    return options;
+}
+
+/* SplitMix64 finalizer */
+inline uint64_t splitMix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Random number counter of a stream */
+inline uint64_t counterRandom(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return splitMix64(seed + splitMix64(stream * 0x9e3779b97f4a7c15ULL)
+                      + (counter + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+/* Random number in [0, 1) */
+inline double unitRandom(uint64_t r) {
+    return (r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Random number in [0, n) */
+inline uint64_t boundedRandom(uint64_t r, uint64_t n) {
+    return (uint64_t) (((unsigned __int128) r * n) >> 64);
+}
+
+/* Number of vertex pairs u < v */
+inline uint64_t numPairs(int numVertices) {
+    return (uint64_t) numVertices * (numVertices - 1) / 2;
+}
+
+/* First pair index of row u, pairs (u, u + 1) .. (u, n - 1) */
+inline uint64_t rowStart(int numVertices, uint64_t u) {
+    return u * numVertices - u * (u + 1) / 2;
+}
+
+/* The pair u < v with the given index, pairs ordered by (u, v) */
+inline void pairFromIndex(int numVertices, uint64_t k, int &u, int &v) {
+    double b = 2.0 * numVertices - 1;
+    int64_t row = (int64_t) ((b - sqrt(b * b - 8.0 * (double) k)) / 2);
+
+    if (row < 0) row = 0;
+    while (row > 0 && rowStart(numVertices, row) > k) row--;
+    while (row + 1 < numVertices && rowStart(numVertices, row + 1) <= k) row++;
+
+    u = (int) row;
+    v = (int) (k - rowStart(numVertices, row) + row + 1);
+}
+
+/* Weight of the edge (u, v), the same however the edge was drawn */
+inline int edgeWeight(const Generator_Options &options, int u, int v) {
+    uint64_t r = counterRandom(options.seed, STREAM_WEIGHT,
+                               (uint64_t) u * options.numVertices + v);
+
+    if (options.weights == WEIGHTS_CONSTANT) return 1;
+    if (options.weights == WEIGHTS_EXPONENTIAL) {
+        double w = 1 - log(1 - unitRandom(r)) * options.maxWeight / 8;
+        return w < options.maxWeight ? (int) w : options.maxWeight;
+    }
+
+    return 1 + (int) boundedRandom(r, options.maxWeight);
+}
+
+/* Fills edge i with the pair (u, v), smaller endpoint first */
+inline void setEdge(const Generator_Options &options, Edge* E, long long i, int u, int v) {
+    E[i].v1 = u < v ? u : v;
+    E[i].v2 = u < v ? v : u;
+    E[i].w = edgeWeight(options, E[i].v1, E[i].v2);
+}
+
+/* Sorts the edges by (v1, v2) and drops the parallel ones
+*
+*  returns the number of edges left, E and ids are swapped with the
+*  scratch buffers as needed
+*/
+inline int sortUniqueEdges(Edge* &E, int* &ids, int numEdges, int numVertices, int maxWeight,
+                           Edge* &tmpE, int* &tmpIds, int numThreads) {
+    radixSortEdges(E, ids, numEdges, numVertices, 1, maxWeight, tmpE, tmpIds, numThreads);
+    numEdges = uniqueEdges(E, ids, numEdges, tmpE, tmpIds, numThreads);
+    std::swap(E, tmpE);
+    std::swap(ids, tmpIds);
+
+    return numEdges;
+}
+
+/* Pair index of the edge, pairs ordered by (u, v) */
+inline uint64_t pairIndex(int numVertices, const Edge &edge) {
+    return rowStart(numVertices, edge.v1) + (edge.v2 - edge.v1 - 1);
+}
+
+/* Samples m distinct pairs out of pairs, sorted by (v1, v2) into E
+*
+*  The first draw is uniform over all pairs; every later one draws the
+*  missing edges by rank among the pairs not taken yet, mapped to their
+*  pair through the sorted edges so far - only the new draws can
+*  collide, so the missing edges fall off doubly exponentially.
+*
+*  E, ids, tmpE, tmpIds => room for m edges, swapped as needed
+*  returns m
+*/
+inline int sampleDistinctPairs(const Generator_Options &options, uint64_t pairs, int m,
+                               Edge* &E, int* &ids, Edge* &tmpE, int* &tmpIds,
+                               int numThreads) {
+    int n = options.numVertices
+    ,   count = 0;
+    uint64_t counter = 0;
+
+    while (count < m) {
+        int missing = m - count;
+        uint64_t free = pairs - count;
+
+        parallelFor(missing, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                uint64_t rank = boundedRandom(counterRandom(options.seed, STREAM_GNM, counter + i),
+                                              free);
+                int u, v;
+
+                /* Free rank j is pair j + the taken pairs at or below it,
+                *  found on pairIndex(E[t]) - t, non-decreasing over the
+                *  sorted taken edges
+                */
+                int taken = (int) (std::upper_bound(E, E + count, rank,
+                                                    [&](uint64_t j, const Edge &e) {
+                    return j < pairIndex(n, e) - (uint64_t) (&e - E);
+                }) - E);
+
+                pairFromIndex(n, rank + taken, u, v);
+                setEdge(options, E, count + i, u, v);
+            }
+        });
+
+        counter += missing;
+        count = sortUniqueEdges(E, ids, count + missing, n, options.maxWeight,
+                                tmpE, tmpIds, numThreads);
+    }
+
+    return count;
+}
+
+/* Edges of one G(n, p) block, written to E if it isn't NULL
+*
+*  returns the number of edges in the block
+*/
+inline int gnpBlock(const Generator_Options &options, uint64_t block, uint64_t first,
+                    uint64_t last, double logSkip, Edge* E) {
+    uint64_t k = first
+    ,        counter = 0;
+    int count = 0;
+
+    for (;;) {
+        /* Gap to the next edge, geometric with parameter p */
+        if (logSkip < 0) {
+            double gap = log(1 - unitRandom(counterRandom(options.seed, (STREAM_GNP << 32) | block,
+                                                          counter++))) / logSkip;
+            if (gap >= (double) (last - k)) break;
+            k += (uint64_t) gap;
+        }
+        if (k >= last) break;
+
+        if (E != NULL) {
+            int u, v;
+
+            pairFromIndex(options.numVertices, k, u, v);
+            setEdge(options, E, count, u, v);
+        }
+        count++;
+        k++;
+    }
+
+    return count;
+}
+
+/* Smallest scale with 2^scale >= numVertices */
+inline int rmatScale(int numVertices) {
+    int scale = 0;
+
+    while ((1LL << scale) < numVertices) scale++;
+    return scale;
+}
+
+/* Scrambles a vertex label of the R-MAT graph - a bijection of
+*  [0, 2^scale) built from odd multipliers and xor-shifts
+*/
+inline uint64_t scrambleVertex(uint64_t v, int scale, uint64_t seed) {
+    uint64_t mask = (1ULL << scale) - 1
+    ,        k1 = counterRandom(seed, STREAM_SCRAMBLE, 0) | 1
+    ,        k2 = counterRandom(seed, STREAM_SCRAMBLE, 1) | 1;
+    int shift = (scale + 1) / 2;
+
+    v = (v * k1) & mask;
+    v ^= v >> shift;
+    v = (v * k2) & mask;
+    v ^= v >> shift;
+
+    return v;
+}
+
+/* Endpoints of R-MAT edge i, on a graph of 2^scale vertices folded into
+*  numVertices if that isn't a power of 2
+*/
+inline void rmatEdge(const Generator_Options &options, int scale, uint64_t i, int &u, int &v) {
+    const double* q = options.quadrants;
+    double total = q[0] + q[1] + q[2] + q[3];
+    uint64_t x = 0
+    ,        y = 0;
+
+    for(int level = 0; level < scale; level++) {
+        double r = total * unitRandom(counterRandom(options.seed, STREAM_RMAT,
+                                                    i * scale + level));
+        int quadrant = r < q[0] ? 0 : r < q[0] + q[1] ? 1 : r < q[0] + q[1] + q[2] ? 2 : 3;
+
+        x = (x << 1) | (quadrant >> 1);
+        y = (y << 1) | (quadrant & 1);
+    }
+
+    u = (int) (scrambleVertex(x, scale, options.seed) % options.numVertices);
+    v = (int) (scrambleVertex(y, scale, options.seed) % options.numVertices);
+}
+
+/* Side of the square (dims 2) or cube (dims 3) holding a grid of
+*  numVertices vertices
+*/
+inline int gridWidth(int numVertices, int dims) {
+    int width = 1;
+
+    while ((dims == 2 ? (long long) width * width
+                      : (long long) width * width * width) < numVertices) width++;
+    return width;
+}
+
+/* Edges from vertex u of a 2D or 3D grid to its next neighbor along
+*  every axis, written to E if it isn't NULL
+*
+*  returns the number of edges of u
+*/
+inline int gridEdges(const Generator_Options &options, int width, int dims, int u, Edge* E) {
+    long long n = options.numVertices
+    ,         plane = (long long) width * width;
+    int x = u % width
+    ,   y = (u / width) % width
+    ,   count = 0;
+
+    if (x + 1 < width && u + 1 < n) {
+        if (E != NULL) setEdge(options, E, count, u, u + 1);
+        count++;
+    }
+    if ((dims == 2 || y + 1 < width) && u + width < n) {
+        if (E != NULL) setEdge(options, E, count, u, u + width);
+        count++;
+    }
+    if (dims == 3 && u + plane < n) {
+        if (E != NULL) setEdge(options, E, count, u, (int) (u + plane));
+        count++;
+    }
+
+    return count;
+}
+
+/* struct(ure) Point_Grid holds random points of the unit square, bucketed
+*  into side x side square cells
+*
+*  x, y => coordinates of every vertex
+*  cellSize => width of a cell, 1 / side
+*  cellStart, cellPoints => vertices of every cell, by increasing index
+*  cellX, cellY => their coordinates in the same order, so a cell is
+*                  scanned from contiguous memory
+*/
+struct Point_Grid {
+    double* x;
+    double* y;
+    int side;
+    double cellSize;
+    int* cellStart;
+    int* cellPoints;
+    double* cellX;
+    double* cellY;
+};
+
+/* Cell of a coordinate in [0, 1) */
+inline int pointCell(const Point_Grid &grid, double c) {
+    int k = (int) (c * grid.side);
+
+    return k < grid.side ? k : grid.side - 1;
+}
+
+/* Squared distance between the point of u and the i-th one of the cells */
+inline double pointDistance(const Point_Grid &grid, int u, int i) {
+    double dx = grid.x[u] - grid.cellX[i]
+    ,      dy = grid.y[u] - grid.cellY[i];
+
+    return dx * dx + dy * dy;
+}
+
+/* Draws the points of every vertex and buckets them into the cells */
+inline Point_Grid makePointGrid(const Generator_Options &options, int side, int numThreads) {
+    int n = options.numVertices;
+    Point_Grid grid;
+    int* cell = new int[n];
+
+    grid.x = new double[n];
+    grid.y = new double[n];
+    grid.side = side;
+    grid.cellSize = 1.0 / side;
+    grid.cellStart = new int[(size_t) side * side + 1];
+    grid.cellPoints = new int[n];
+    grid.cellX = new double[n];
+    grid.cellY = new double[n];
+
+    parallelFor(n, numThreads, [&](int begin, int end) {
+        for(int v = begin; v < end; v++) {
+            grid.x[v] = unitRandom(counterRandom(options.seed, STREAM_POINTS, 2 * (uint64_t) v));
+            grid.y[v] = unitRandom(counterRandom(options.seed, STREAM_POINTS, 2 * (uint64_t) v + 1));
+            cell[v] = pointCell(grid, grid.y[v]) * side + pointCell(grid, grid.x[v]);
+        }
+    });
+
+    /* Counting sort of the vertices by cell */
+    for(int c = 0; c <= side * side; c++)
+        grid.cellStart[c] = 0;
+    for(int v = 0; v < n; v++)
+        grid.cellStart[cell[v] + 1]++;
+    for(int c = 0; c < side * side; c++)
+        grid.cellStart[c + 1] += grid.cellStart[c];
+    for(int v = 0; v < n; v++)
+        grid.cellPoints[grid.cellStart[cell[v]]++] = v;
+    for(int c = side * side; c > 0; c--)
+        grid.cellStart[c] = grid.cellStart[c - 1];
+    grid.cellStart[0] = 0;
+
+    parallelFor(n, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            grid.cellX[i] = grid.x[grid.cellPoints[i]];
+            grid.cellY[i] = grid.y[grid.cellPoints[i]];
+        }
+    });
+
+    delete [] cell;
+    return grid;
+}
+
+inline void freePointGrid(Point_Grid &grid) {
+    delete [] grid.x;
+    delete [] grid.y;
+    delete [] grid.cellStart;
+    delete [] grid.cellPoints;
+    delete [] grid.cellX;
+    delete [] grid.cellY;
+}
+
+/* Edges from vertex u to the vertices above it at most radius away,
+*  written to E if it isn't NULL - the cells are at least radius wide,
+*  so they all lie in the 3 x 3 cells around u
+*
+*  returns the number of edges of u
+*/
+inline int geometricEdges(const Generator_Options &options, const Point_Grid &grid,
+                          double radius, int u, Edge* E) {
+    int cx = pointCell(grid, grid.x[u])
+    ,   cy = pointCell(grid, grid.y[u])
+    ,   count = 0;
+
+    for(int y = cy - 1; y <= cy + 1; y++) {
+        for(int x = cx - 1; x <= cx + 1; x++) {
+            if (x < 0 || y < 0 || x >= grid.side || y >= grid.side) continue;
+
+            int c = y * grid.side + x;
+
+            for(int k = grid.cellStart[c]; k < grid.cellStart[c + 1]; k++) {
+                int v = grid.cellPoints[k];
+
+                if (v <= u || pointDistance(grid, u, k) > radius * radius) continue;
+
+                if (E != NULL) setEdge(options, E, count, u, v);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/* Edges from vertex u to its k nearest neighbors, ties going to the
+*  smaller index. The cells are searched ring by ring around u, until
+*  the k-th neighbor is nearer than anything beyond the ring.
+*
+*  best, bestDistance => scratch space for k neighbors
+*  returns k, the number of edges written to E
+*/
+inline int knnEdges(const Generator_Options &options, const Point_Grid &grid, int k, int u,
+                    int* best, double* bestDistance, Edge* E) {
+    int cx = pointCell(grid, grid.x[u])
+    ,   cy = pointCell(grid, grid.y[u])
+    ,   found = 0;
+
+    if (k == 0) return 0;
+
+    for(int ring = 0; ring <= grid.side; ring++) {
+        for(int y = cy - ring; y <= cy + ring; y++) {
+            for(int x = cx - ring; x <= cx + ring; x++) {
+                /* Only the border of the ring, the inside is done */
+                if (y != cy - ring && y != cy + ring && x != cx - ring && x != cx + ring) continue;
+                if (x < 0 || y < 0 || x >= grid.side || y >= grid.side) continue;
+
+                int c = y * grid.side + x;
+
+                for(int i = grid.cellStart[c]; i < grid.cellStart[c + 1]; i++) {
+                    int v = grid.cellPoints[i];
+                    double d = pointDistance(grid, u, i);
+
+                    if (v == u) continue;
+                    if (found == k && (d > bestDistance[k - 1]
+                                       || (d == bestDistance[k - 1] && v > best[k - 1]))) continue;
+
+                    /* Insertion into the sorted neighbors */
+                    int j = found < k ? found++ : k - 1;
+
+                    while (j > 0 && (bestDistance[j - 1] > d
+                                     || (bestDistance[j - 1] == d && best[j - 1] > v))) {
+                        best[j] = best[j - 1];
+                        bestDistance[j] = bestDistance[j - 1];
+                        j--;
+                    }
+                    best[j] = v;
+                    bestDistance[j] = d;
+                }
+            }
+        }
+
+        /* Points beyond the ring are more than ring cells away */
+        double reach = ring * grid.cellSize;
+
+        if (found == k && bestDistance[k - 1] < reach * reach) break;
+    }
+
+    for(int j = 0; j < found; j++)
+        setEdge(options, E, j, u, best[j]);
+
+    return found;
+}
+
+/* Pseudo-random number of one matrix cell - a hash of (seed, cell), so
+*  every row can be filled by any thread and still give the same graph
+*/
+inline uint32_t cellRandom(uint64_t seed, uint64_t cell) {
+    return (uint32_t) (splitMix64(seed + (cell + 1) * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+/* Fills the zeroed V x V adjacency matrix of the matrix model, one row
+*  per task. Cells (i, j) and (j, i) hash the same cell id, so every row
+*  is filled front to back by its own task, without writes into the
+*  other rows, and a seed gives the same graph in every program.
+*
+*  returns the number of edges - the cells (j > i) of weight above 0
+*/
+inline int fillMatrixGraph(Dense_Matrix &adjMatrix, const Generator_Options &options,
+                           int numThreads) {
+    int n = adjMatrix.numRows;
+
+    return parallelReduce<int>(n, numThreads, 0, [&](int begin, int end) {
+        int valid = 0;
+
+        for(int i = begin; i < end; i++) {
+            int* row = matrixRow(adjMatrix, i);
+
+            for(int j = 0; j < n; j++) {
+                if (j == i) continue;
+
+                uint64_t cell = i < j ? (uint64_t) i * n + j : (uint64_t) j * n + i;
+                row[j] = (int) (cellRandom(options.seed, cell) % options.maxWeight) - 1;
+
+                if (j > i && row[j] > 0)
+                    valid++;
+            }
+        }
+
+        return valid;
+    }, [](int a, int b) { return a + b; });
+}
+
+/* Generates the edge list of a random graph of any model but the matrix
+*
+*  numEdges => number of edges generated, -1 if they don't fit an int
+*  returns the edge list, NULL on error
+*/
+inline Edge* generateEdgeList(const Generator_Options &options, int &numEdges, int numThreads) {
+    int n = options.numVertices;
+    uint64_t pairs = numPairs(n);
+    long long wanted = 0;
+    int backbone = options.connected && n > 1 ? n - 1 : 0;
+
+    numEdges = -1;
+    if (n < 1 || options.maxWeight < 1) return NULL;
+
+    /* G(n, p): counts the edges of every block, then fills them */
+    uint64_t numBlocks = pairs / GNP_BLOCK_PAIRS + 1;
+    if (numBlocks > GNP_MAX_BLOCKS) numBlocks = GNP_MAX_BLOCKS;
+
+    uint64_t blockPairs = (pairs + numBlocks - 1) / numBlocks;
+    double p = options.probability
+    ,      logSkip = p >= 1 ? 0 : log(1 - p);
+    int* blockOffsets = NULL;
+
+    if (options.model == GRAPH_GNP) {
+        if (p <= 0) numBlocks = 0;
+        blockOffsets = new int[numBlocks + 1];
+
+        wanted = parallelReduce<long long>((int) numBlocks, numThreads, 0,
+                                           [&](int begin, int end) {
+            long long count = 0;
+
+            for(int b = begin; b < end; b++) {
+                uint64_t first = b * blockPairs
+                ,        last = first + blockPairs < pairs ? first + blockPairs : pairs;
+
+                blockOffsets[b] = first < last ? gnpBlock(options, b, first, last, logSkip, NULL) : 0;
+                count += blockOffsets[b];
+            }
+
+            return count;
+        }, [](long long a, long long b) { return a + b; });
+    } else if (options.model == GRAPH_GNM) {
+        wanted = options.numEdges < (long long) pairs ? options.numEdges : (long long) pairs;
+    } else if (options.model == GRAPH_RMAT) {
+        wanted = (long long) options.edgeFactor << rmatScale(n);
+    }
+
+    /* Spatial models: the points first, then the edges of every block */
+    bool spatial = options.model >= GRAPH_GRID2D;
+    int width = gridWidth(n, options.model == GRAPH_GRID3D ? 3 : 2)
+    ,   k = options.neighbors < n - 1 ? options.neighbors : n - 1
+    ,   numSpatialBlocks = (n + SPATIAL_BLOCK_VERTICES - 1) / SPATIAL_BLOCK_VERTICES;
+    double radius = options.radius > 0 ? options.radius : sqrt(GEOMETRIC_DEGREE / (M_PI * n));
+    Point_Grid points = { NULL, NULL, 0, 0.0, NULL, NULL, NULL, NULL };
+
+    if (options.model == GRAPH_GEOMETRIC || options.model == GRAPH_KNN) {
+        int side = options.model == GRAPH_GEOMETRIC ? (int) (1 / radius)
+                                                    : (int) sqrt((double) n / (k > 0 ? k : 1))
+        ,   maxSide = (int) sqrt((double) n);
+
+        if (side > maxSide) side = maxSide;
+        if (side < 1) side = 1;
+        points = makePointGrid(options, side, numThreads);
+    }
+
+    /* Edges of the i-th vertex, written to E if it isn't NULL - points go
+    *  cell by cell, so the cells around a vertex are mostly in cache
+    */
+    auto spatialEdges = [&](int i, int* best, double* bestDistance, Edge* E) {
+        int u = points.cellPoints != NULL ? points.cellPoints[i] : i;
+
+        if (options.model == GRAPH_GEOMETRIC) return geometricEdges(options, points, radius, u, E);
+        if (options.model == GRAPH_KNN) return E != NULL ? knnEdges(options, points, k, u, best,
+                                                                    bestDistance, E) : k;
+        return gridEdges(options, width, options.model == GRAPH_GRID3D ? 3 : 2, u, E);
+    };
+
+    if (spatial) {
+        blockOffsets = new int[numSpatialBlocks + 1];
+
+        wanted = parallelReduce<long long>(numSpatialBlocks, numThreads, 0,
+                                           [&](int begin, int end) {
+            long long count = 0;
+
+            for(int b = begin; b < end; b++) {
+                int first = b * SPATIAL_BLOCK_VERTICES
+                ,   last = n - first < SPATIAL_BLOCK_VERTICES ? n : first + SPATIAL_BLOCK_VERTICES;
+
+                blockOffsets[b] = 0;
+                for(int u = first; u < last; u++)
+                    blockOffsets[b] += spatialEdges(u, NULL, NULL, NULL);
+                count += blockOffsets[b];
+            }
+
+            return count;
+        }, [](long long a, long long b) { return a + b; });
+    }
+
+    if (wanted + backbone > INT_MAX) {
+        delete [] blockOffsets;
+        if (points.x != NULL) freePointGrid(points);
+        return NULL;
+    }
+
+    int capacity = (int) wanted + backbone;
+    Edge* E = new Edge[capacity];
+    Edge* tmpE = new Edge[capacity];
+    int* ids = new int[capacity];
+    int* tmpIds = new int[capacity];
+    int count = 0;
+
+    if (options.model == GRAPH_GNP) {
+        exclusiveScan(blockOffsets, blockOffsets, (int) numBlocks, numThreads);
+
+        parallelFor((int) numBlocks, numThreads, [&](int begin, int end) {
+            for(int b = begin; b < end; b++) {
+                uint64_t first = b * blockPairs
+                ,        last = first + blockPairs < pairs ? first + blockPairs : pairs;
+
+                if (first < last) gnpBlock(options, b, first, last, logSkip, E + blockOffsets[b]);
+            }
+        });
+        count = (int) wanted;
+    } else if (options.model == GRAPH_GNM && wanted <= (long long) (pairs / 2)) {
+        /* G(n, m): m distinct pairs sampled straight */
+        count = sampleDistinctPairs(options, pairs, (int) wanted, E, ids, tmpE, tmpIds,
+                                    numThreads);
+    } else if (options.model == GRAPH_GNM) {
+        /* Dense G(n, m): samples the pairs left out, then every row emits
+        *  the others in order from its own offset
+        */
+        int excluded = (int) (pairs - wanted);
+        Edge* X = new Edge[excluded + 1];
+        Edge* tmpX = new Edge[excluded + 1];
+        int* xIds = new int[excluded + 1];
+        int* tmpXIds = new int[excluded + 1];
+
+        sampleDistinctPairs(options, pairs, excluded, X, xIds, tmpX, tmpXIds, numThreads);
+
+        parallelFor(n - 1, numThreads, [&](int begin, int end) {
+            for(int u = begin; u < end; u++) {
+                uint64_t k = rowStart(n, u);
+                int x = (int) (std::lower_bound(X, X + excluded, k,
+                                                [&](const Edge &e, uint64_t key) {
+                    return pairIndex(n, e) < key;
+                }) - X);
+                long long pos = (long long) (k - x);
+
+                for(int v = u + 1; v < n; v++, k++) {
+                    if (x < excluded && pairIndex(n, X[x]) == k) {
+                        x++;
+                        continue;
+                    }
+                    setEdge(options, E, pos++, u, v);
+                }
+            }
+        });
+        count = (int) wanted;
+
+        delete [] X;
+        delete [] tmpX;
+        delete [] xIds;
+        delete [] tmpXIds;
+    } else if (options.model == GRAPH_RMAT) {
+        /* R-MAT: draws every edge, then drops the self-loops and duplicates */
+        int scale = rmatScale(n);
+        int* label = new int[n];
+
+        parallelFor((int) wanted, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                int u, v;
+
+                rmatEdge(options, scale, i, u, v);
+                setEdge(options, E, i, u, v);
+                ids[i] = i;
+            }
+        });
+
+        parallelFor(n, numThreads, [&](int begin, int end) {
+            for(int v = begin; v < end; v++)
+                label[v] = v;
+        });
+
+        count = compactEdges(E, ids, (int) wanted, label, tmpE, tmpIds, numThreads);
+        std::swap(E, tmpE);
+        std::swap(ids, tmpIds);
+        count = sortUniqueEdges(E, ids, count, n, options.maxWeight, tmpE, tmpIds, numThreads);
+
+        delete [] label;
+    } else if (spatial) {
+        exclusiveScan(blockOffsets, blockOffsets, numSpatialBlocks, numThreads);
+
+        parallelFor(numSpatialBlocks, numThreads, [&](int begin, int end) {
+            int* best = new int[k > 0 ? k : 1];
+            double* bestDistance = new double[k > 0 ? k : 1];
+
+            for(int b = begin; b < end; b++) {
+                int first = b * SPATIAL_BLOCK_VERTICES
+                ,   last = n - first < SPATIAL_BLOCK_VERTICES ? n : first + SPATIAL_BLOCK_VERTICES
+                ,   pos = blockOffsets[b];
+
+                for(int u = first; u < last; u++)
+                    pos += spatialEdges(u, best, bestDistance, E + pos);
+            }
+
+            delete [] best;
+            delete [] bestDistance;
+        });
+
+        /* The kNN lists of two mutual neighbors hold their edge twice */
+        count = sortUniqueEdges(E, ids, (int) wanted, n, options.maxWeight,
+                                tmpE, tmpIds, numThreads);
+        if (points.x != NULL) freePointGrid(points);
+    }
+
+    /* Backbone: every vertex v > 0 hangs off a random vertex below it */
+    if (backbone > 0) {
+        parallelFor(backbone, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                int v = i + 1
+                ,   u = (int) boundedRandom(counterRandom(options.seed, STREAM_BACKBONE, v), v);
+
+                setEdge(options, E, count + i, u, v);
+            }
+        });
+
+        count = sortUniqueEdges(E, ids, count + backbone, n, options.maxWeight,
+                                tmpE, tmpIds, numThreads);
+    }
+
+    delete [] blockOffsets;
+    delete [] tmpE;
+    delete [] ids;
+    delete [] tmpIds;
+
+    numEdges = count;
+    return E;
+}
+
+/* Parses one generator option of the command line at argv[i]
+*
+*  --graph matrix|gnp|gnm|rmat|grid2d|grid3d|geometric|knn => model of the random graph
+*  --vertices N, --edges M, --probability P => size of the graph
+*  --scale S, --edge-factor F => 2^S vertices, F * 2^S edges (rmat)
+*  --rmat A,B,C,D => quadrant probabilities (rmat)
+*  --radius R => distance joining two points (geometric)
+*  --neighbors K => nearest neighbors of every point (knn)
+*  --weights uniform|constant|exponential, --max-weight W => edge weights
+*  --seed S => seed of the generator, the same seed gives the same graph
+*  --connected => adds a random spanning tree
+*  --input FILE => reads the graph from a file instead: a binary graph
+*                  file (graph_file.h), or a DIMACS .gr, SNAP edge list
+*                  or Matrix Market text file (text_graph.h)
+*  --verify => checks every index of a binary graph file, reading all
+*              of it
+*
+*  returns false if argv[i] isn't a (valid) generator option, otherwise
+*  leaves i on its last argument
+*/
+inline bool parseGeneratorOption(int argc, char** argv, int &i, Generator_Options &options) {
+    const char* option = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(option, "--connected") == 0) {
+        options.connected = true;
+        return true;
+    }
+    if (strcmp(option, "--verify") == 0) {
+        options.verify = true;
+        return true;
+    }
+    if (value == NULL) return false;
+
+    if (strcmp(option, "--graph") == 0) {
+        int k = 0;
+
+        while (k < NUM_GRAPH_MODELS && strcmp(value, graphModelNames[k]) != 0) k++;
+        if (k == NUM_GRAPH_MODELS) return false;
+        options.model = (Graph_Model) k;
+    } else if (strcmp(option, "--weights") == 0) {
+        int k = 0;
+
+        while (k < NUM_WEIGHT_DISTRIBUTIONS && strcmp(value, weightDistributionNames[k]) != 0) k++;
+        if (k == NUM_WEIGHT_DISTRIBUTIONS) return false;
+        options.weights = (Weight_Distribution) k;
+    } else if (strcmp(option, "--vertices") == 0 && atoi(value) > 0) {
+        options.numVertices = atoi(value);
+    } else if (strcmp(option, "--edges") == 0 && atoll(value) >= 0) {
+        options.numEdges = atoll(value);
+    } else if (strcmp(option, "--probability") == 0 && atof(value) >= 0 && atof(value) <= 1) {
+        options.probability = atof(value);
+    } else if (strcmp(option, "--scale") == 0 && atoi(value) >= 0 && atoi(value) <= 30) {
+        options.numVertices = 1 << atoi(value);
+    } else if (strcmp(option, "--edge-factor") == 0 && atoi(value) > 0) {
+        options.edgeFactor = atoi(value);
+    } else if (strcmp(option, "--rmat") == 0) {
+        double* q = options.quadrants;
+
+        if (sscanf(value, "%lf,%lf,%lf,%lf", &q[0], &q[1], &q[2], &q[3]) != 4
+            || q[0] < 0 || q[1] < 0 || q[2] < 0 || q[3] < 0 || q[0] + q[1] + q[2] + q[3] <= 0)
+            return false;
+    } else if (strcmp(option, "--radius") == 0 && atof(value) > 0) {
+        options.radius = atof(value);
+    } else if (strcmp(option, "--neighbors") == 0 && atoi(value) > 0) {
+        options.neighbors = atoi(value);
+    } else if (strcmp(option, "--max-weight") == 0 && atoi(value) > 0) {
+        options.maxWeight = atoi(value);
+    } else if (strcmp(option, "--input") == 0) {
+        options.input = value;
+    } else if (strcmp(option, "--seed") == 0) {
+        options.seed = strtoull(value, NULL, 10);
+    } else {
+        return false;
+    }
+
+    i++;
+    return true;
+}
+
+#endif
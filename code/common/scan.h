@@ -0,0 +1,79 @@
+/* scan.h
+*
+*  Multi-threaded exclusive prefix sum (scan) on the host. Every thread
+*  sums its own chunk, the chunk totals are scanned serially and every
+*  thread then scans its chunk from its offset - 2n reads and n writes.
+*
+*/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <vector>
+
+#include "parallel.h"
+#include "isa_dispatch.h"
+
+/* Below this many elements per thread the scan runs serially */
+#define SCAN_MIN_CHUNK 16384
+
+/* Sum of a chunk - int chunks go through the ISA dispatch table */
+template <typename T>
+T chunkSum(const T* in, size_t n) {
+    T sum = 0;
+
+    for(size_t i = 0; i < n; i++)
+        sum += in[i];
+
+    return sum;
+}
+
+inline int chunkSum(const int* in, size_t n) {
+    return isa().sumInts(in, n);
+}
+
+/* Exclusive scan of in[0, n) into out[0, n) - in and out may be the same
+*  array. Works for any integer type (int, unsigned, int64_t, uint64_t).
+*
+*  returns the sum of all n elements
+*/
+template <typename T>
+T exclusiveScan(const T* in, T* out, size_t n, int numThreads) {
+    if ((size_t) numThreads > n / SCAN_MIN_CHUNK) numThreads = (int) (n / SCAN_MIN_CHUNK);
+    if (numThreads < 1) numThreads = 1;
+
+    size_t chunk = (n + numThreads - 1) / numThreads;
+    std::vector<T> sums(numThreads + 1, 0);
+
+    /* Sums every chunk */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            size_t first = t * chunk, last = first + chunk < n ? first + chunk : n;
+
+            sums[t + 1] = first < last ? chunkSum(in + first, last - first) : 0;
+        }
+    });
+
+    /* Scans the chunk totals */
+    for(int t = 0; t < numThreads; t++)
+        sums[t + 1] += sums[t];
+
+    /* Scans every chunk from its offset */
+    parallelFor(numThreads, numThreads, [&](int begin, int end) {
+        for(int t = begin; t < end; t++) {
+            size_t first = t * chunk, last = first + chunk < n ? first + chunk : n;
+            T running = sums[t];
+
+            for(size_t i = first; i < last; i++) {
+                T value = in[i];
+                out[i] = running;
+                running += value;
+            }
+        }
+    });
+
+    return sums[numThreads];
+}
+
+#endif
@@ -0,0 +1,598 @@
+/* text_graph.h
+*
+*  Multi-threaded reader of graphs in text form, straight over the
+*  mmap'ed file:
+*
+*  dimacs => DIMACS shortest path (.gr): "c" comments, "p sp V E", then
+*            one "a u v w" line per arc, vertices from 1
+*  snap => SNAP edge list: "#" comments, then "u v" or "u v w" per line,
+*          vertices from 0
+*  mtx => Matrix Market coordinate: the %%MatrixMarket banner, "%"
+*         comments, "rows cols entries", then "i j [value]" per entry,
+*         vertices from 1
+*
+*  The format is told by the first line. The file is cut into chunks at
+*  line boundaries and every chunk is parsed by its own task into its own
+*  bucket of edges, with hand-written number parsing. The buckets are
+*  then concatenated, self-loops are dropped and the edges sorted, the
+*  lightest of parallel edges kept - a .gr file lists every road in both
+*  directions.
+*
+*  Integer weights are taken as they are (absolute value, at least 1),
+*  real ones scaled by TEXT_REAL_SCALE first; edges without one get a
+*  weight drawn like the ones of the random graphs (--weights, --max-weight,
+*  --seed).
+*
+*  The graph of --input is either such a text file or a binary graph
+*  file (graph_file.h), told apart by the magic of the latter.
+*
+*/
+
+#ifndef TEXT_GRAPH_H
+#define TEXT_GRAPH_H
+
+#include <climits>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+#include "parallel.h"
+#include "scan.h"
+#include "radix_sort.h"
+#include "compact.h"
+#include "isa_dispatch.h"
+#include "random_graph.h"
+#include "graph_file.h"
+
+/* Chunks per thread, and the fewest bytes in a chunk */
+#define TEXT_CHUNKS_PER_THREAD 8
+#define TEXT_MIN_CHUNK (1 << 20)
+
+/* Factor turning real weights into integer ones */
+#define TEXT_REAL_SCALE 1000
+
+/* Formats of a text graph */
+enum Text_Format {
+    TEXT_DIMACS,
+    TEXT_SNAP,
+    TEXT_MTX,
+    NUM_TEXT_FORMATS
+};
+
+const char* const textFormatNames[NUM_TEXT_FORMATS] = { "dimacs", "snap", "mtx" };
+
+/* Outcomes of reading a text graph */
+enum Text_Graph_Status {
+    TEXT_GRAPH_OK,
+    TEXT_GRAPH_OPEN,
+    TEXT_GRAPH_FORMAT,
+    TEXT_GRAPH_SYNTAX,
+    TEXT_GRAPH_TOO_LARGE,
+    NUM_TEXT_GRAPH_STATUSES
+};
+
+const char* const textGraphStatusNames[NUM_TEXT_GRAPH_STATUSES] = {
+    "ok", "can't open or map the file", "unknown or unsupported format",
+    "malformed line", "graph too large for int indices"
+};
+
+/* Kinds of values of a text graph */
+enum Text_Values {
+    VALUES_NONE,
+    VALUES_INTEGER,
+    VALUES_REAL
+};
+
+/* struct(ure) Text_Chunk holds what one task parsed
+*
+*  begin, end => lines starting in [begin, end)
+*  edges => bucket of the edges read, w is 0 if the line had no weight
+*  maxVertex => largest vertex seen, -1 if none
+*  error => first malformed line, NULL if none
+*/
+struct Text_Chunk {
+    const char* begin;
+    const char* end;
+    std::vector<Edge> edges;
+    long long maxVertex;
+    const char* error;
+};
+
+/* Skips spaces and tabs (and the \r of DOS line ends) */
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p;
+}
+
+/* Start of the line after the one holding p */
+inline const char* nextLine(const char* p, const char* end) {
+    const char* newline = p < end ? (const char*) memchr(p, '\n', end - p) : NULL;
+
+    return newline != NULL ? newline + 1 : end;
+}
+
+/* Whether p ends a token */
+inline bool tokenEnd(const char* p, const char* end) {
+    return p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+}
+
+/* Parses a decimal integer of 18 digits at most at p, moving p past it */
+inline bool parseInteger(const char* &p, const char* end, long long &value) {
+    bool negative = p < end && *p == '-';
+    unsigned long long magnitude = 0;
+    const char* digits;
+
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    for(digits = p; p < end && (unsigned) (*p - '0') < 10; p++)
+        magnitude = magnitude * 10 + (*p - '0');
+    if (p == digits || p - digits > 18) return false;
+
+    value = negative ? -(long long) magnitude : (long long) magnitude;
+    return tokenEnd(p, end);
+}
+
+/* Parses a decimal real number at p (digits, point, exponent), moving
+*  p past it - 19 significant digits at most, the others only scale it
+*/
+inline bool parseReal(const char* &p, const char* end, double &value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    bool negative = p < end && *p == '-';
+    unsigned long long mantissa = 0;
+    int exponent = 0
+    ,   significant = 0
+    ,   digits = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    for(; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significant += mantissa > 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa > 0;
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0) return false;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        long long scale;
+
+        p++;
+        if (!parseInteger(p, end, scale) || scale > 1000 || scale < -1000) return false;
+        exponent += (int) scale;
+    }
+
+    value = (double) mantissa;
+    if (exponent >= -22 && exponent <= 22)
+        value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    else
+        value *= pow(10.0, exponent);
+    if (negative) value = -value;
+
+    return tokenEnd(p, end);
+}
+
+/* Integer weight of a value read from the file */
+inline int textWeight(long long integer, double real, Text_Values values) {
+    if (values == VALUES_REAL) {
+        double w = fabs(real) * TEXT_REAL_SCALE + 0.5;
+
+        if (w >= INT_MAX) return INT_MAX - 1;
+        return w < 1 ? 1 : (int) w;
+    }
+
+    if (integer < 0) integer = -integer;
+    if (integer >= INT_MAX) return INT_MAX - 1;
+    return integer < 1 ? 1 : (int) integer;
+}
+
+/* Parses the edges of the lines starting in the chunk into its bucket
+*
+*  firstVertex => label of the first vertex in the file, 0 or 1
+*  values => kind of the third column, VALUES_NONE if there is none
+*/
+inline void parseTextChunk(Text_Chunk &chunk, const char* fileEnd, Text_Format format,
+                           int firstVertex, Text_Values values) {
+    const char* line = chunk.begin;
+
+    chunk.maxVertex = -1;
+    chunk.error = NULL;
+    chunk.edges.reserve((chunk.end - chunk.begin) / 16);
+
+    while (line < chunk.end) {
+        const char* p = skipBlanks(line, fileEnd);
+        long long u = 0, v = 0, integer = 0;
+        double real = 0;
+        bool ok;
+
+        /* Blank lines and comments */
+        if (p == fileEnd || *p == '\n' || *p == '#' || *p == '%'
+            || (format == TEXT_DIMACS && (*p == 'c' || *p == 'p'))) {
+            line = nextLine(p, fileEnd);
+            continue;
+        }
+
+        /* The fields are parsed in one pass, up to the line end */
+        if (format == TEXT_DIMACS) {
+            ok = *p == 'a';
+            p = skipBlanks(p + 1, fileEnd);
+        } else {
+            ok = true;
+        }
+
+        ok = ok && parseInteger(p, fileEnd, u);
+        p = skipBlanks(p, fileEnd);
+        ok = ok && parseInteger(p, fileEnd, v);
+        p = skipBlanks(p, fileEnd);
+
+        /* The weight, mandatory in DIMACS and valued Matrix Market files */
+        Text_Values kind = VALUES_NONE;
+
+        if (ok && p < fileEnd && *p != '\n') {
+            const char* start = p;
+
+            if (format == TEXT_MTX && values == VALUES_NONE) {
+                ok = false;
+            } else if (values != VALUES_REAL && parseInteger(p, fileEnd, integer)) {
+                kind = VALUES_INTEGER;
+            } else {
+                /* Reals where integers are expected are rounded, SNAP
+                *  weights may be either
+                */
+                p = start;
+                ok = parseReal(p, fileEnd, real);
+                kind = values == VALUES_NONE ? VALUES_REAL : values;
+                integer = (long long) (fabs(real) + 0.5);
+            }
+            p = skipBlanks(p, fileEnd);
+        } else if (format == TEXT_DIMACS || values != VALUES_NONE) {
+            ok = false;
+        }
+
+        u -= firstVertex;
+        v -= firstVertex;
+        if (!ok || (p < fileEnd && *p != '\n') || u < 0 || v < 0 || u >= INT_MAX || v >= INT_MAX) {
+            chunk.error = line;
+            return;
+        }
+
+        if (u != v) {
+            Edge edge;
+
+            edge.v1 = (int) (u < v ? u : v);
+            edge.v2 = (int) (u < v ? v : u);
+            edge.w = kind != VALUES_NONE ? textWeight(integer, real, kind) : 0;
+            chunk.edges.push_back(edge);
+        }
+        if (u > chunk.maxVertex) chunk.maxVertex = u;
+        if (v > chunk.maxVertex) chunk.maxVertex = v;
+
+        line = p < fileEnd ? p + 1 : fileEnd;
+    }
+}
+
+/* Reads the header of a text graph: tells its format, and leaves data
+*  on the first line holding edges
+*
+*  numVertices => vertices the header announces, 0 if it says nothing
+*/
+inline Text_Graph_Status readTextHeader(const char* &data, const char* end, Text_Format &format,
+                                        Text_Values &values, long long &numVertices) {
+    const char* p = skipBlanks(data, end);
+
+    numVertices = 0;
+    values = VALUES_NONE;
+
+    if (end - p >= 14 && strncmp(p, "%%MatrixMarket", 14) == 0) {
+        const char* next = nextLine(p, end);
+        std::string banner(p, next);
+
+        format = TEXT_MTX;
+        for(size_t i = 0; i < banner.size(); i++)
+            banner[i] = (char) tolower(banner[i]);
+        if (banner.find("coordinate") == std::string::npos
+            || banner.find("complex") != std::string::npos)
+            return TEXT_GRAPH_FORMAT;
+        if (banner.find("real") != std::string::npos) values = VALUES_REAL;
+        else if (banner.find("integer") != std::string::npos) values = VALUES_INTEGER;
+
+        /* Comments, then the size line */
+        for (p = next; p < end; p = next) {
+            next = nextLine(p, end);
+            p = skipBlanks(p, next);
+            if (p == next || *p == '\n' || *p == '%') continue;
+
+            long long rows, cols, entries;
+
+            if (!parseInteger(p, next, rows)) return TEXT_GRAPH_SYNTAX;
+            p = skipBlanks(p, next);
+            if (!parseInteger(p, next, cols)) return TEXT_GRAPH_SYNTAX;
+            p = skipBlanks(p, next);
+            if (!parseInteger(p, next, entries)) return TEXT_GRAPH_SYNTAX;
+
+            numVertices = rows > cols ? rows : cols;
+            data = next;
+            return TEXT_GRAPH_OK;
+        }
+
+        return TEXT_GRAPH_SYNTAX;
+    }
+
+    /* DIMACS from its first line - a comment, the problem or an arc */
+    if (p < end && (*p == 'c' || *p == 'p' || *p == 'a')) {
+        format = TEXT_DIMACS;
+        values = VALUES_INTEGER;
+
+        for (; p < end && (*p == 'c' || *p == 'p' || *p == '\n'); p = skipBlanks(p, end)) {
+            const char* next = nextLine(p, end);
+
+            if (*p == 'p') {
+                const char* q = skipBlanks(p + 1, next);
+
+                while (q < next && *q != ' ' && *q != '\t') q++;
+                q = skipBlanks(q, next);
+                if (!parseInteger(q, next, numVertices)) return TEXT_GRAPH_SYNTAX;
+            }
+            p = next;
+        }
+
+        data = p;
+        return TEXT_GRAPH_OK;
+    }
+
+    if (p == end || *p == '#' || (*p >= '0' && *p <= '9')) {
+        format = TEXT_SNAP;
+        return TEXT_GRAPH_OK;
+    }
+
+    return TEXT_GRAPH_FORMAT;
+}
+
+/* Reads a text graph from a mapping of its file
+*
+*  weights => how edges without a weight get one
+*  E => the edges, v1 < v2, sorted, without parallel edges
+*  errorLine => line of the first malformed one
+*/
+inline Text_Graph_Status parseTextGraph(const char* base, size_t bytes,
+                                        const Generator_Options &weights, int numThreads,
+                                        Edge* &E, int &numEdges, int &numVertices,
+                                        Text_Format &format, long long &errorLine) {
+    const char* end = base + bytes;
+    const char* data = base;
+    Text_Values values;
+    long long announced;
+    Text_Graph_Status status = readTextHeader(data, end, format, values, announced);
+
+    E = NULL;
+    errorLine = 0;
+    if (status != TEXT_GRAPH_OK) return status;
+
+    /* Cuts the data into chunks at line boundaries */
+    size_t dataBytes = end - data;
+    int numChunks = numThreads * TEXT_CHUNKS_PER_THREAD;
+
+    if ((size_t) numChunks > dataBytes / TEXT_MIN_CHUNK) numChunks = (int) (dataBytes / TEXT_MIN_CHUNK);
+    if (numChunks < 1) numChunks = 1;
+
+    std::vector<Text_Chunk> chunks(numChunks);
+
+    for(int c = 0; c < numChunks; c++) {
+        const char* nominal = data + dataBytes / numChunks * c;
+
+        chunks[c].begin = c == 0 ? data : nextLine(nominal - 1, end);
+        if (c > 0) chunks[c - 1].end = chunks[c].begin;
+    }
+    chunks[numChunks - 1].end = end;
+
+    /* Parses every chunk into its bucket */
+    parallelFor(numChunks, numThreads, [&](int begin, int last) {
+        for(int c = begin; c < last; c++)
+            parseTextChunk(chunks[c], end, format, format == TEXT_SNAP ? 0 : 1, values);
+    });
+
+    long long maxVertex = announced - 1
+    ,         total = 0;
+    std::vector<long long> offsets(numChunks);
+
+    for(int c = 0; c < numChunks; c++) {
+        if (chunks[c].error != NULL) {
+            /* Counts the lines before the first malformed one */
+            errorLine = 1;
+            for(const char* p = base; (p = (const char*) memchr(p, '\n', chunks[c].error - p)) != NULL; p++)
+                errorLine++;
+            return TEXT_GRAPH_SYNTAX;
+        }
+
+        if (chunks[c].maxVertex > maxVertex) maxVertex = chunks[c].maxVertex;
+        offsets[c] = total;
+        total += chunks[c].edges.size();
+    }
+
+    /* The CSR form holds every edge twice, in int offsets */
+    if (total > INT_MAX / 2 || maxVertex >= INT_MAX - 1) return TEXT_GRAPH_TOO_LARGE;
+
+    numEdges = (int) total;
+    numVertices = (int) (maxVertex + 1);
+
+    /* Concatenates the buckets */
+    Edge* tmpE = new Edge[numEdges];
+    int* ids = new int[numEdges];
+    int* tmpIds = new int[numEdges];
+    Generator_Options drawn = weights;
+
+    E = new Edge[numEdges];
+    drawn.numVertices = numVertices;
+
+    parallelFor(numChunks, numThreads, [&](int begin, int last) {
+        for(int c = begin; c < last; c++) {
+            if (!chunks[c].edges.empty())
+                memcpy(E + offsets[c], &chunks[c].edges[0], sizeof(Edge) * chunks[c].edges.size());
+            std::vector<Edge>().swap(chunks[c].edges);
+        }
+    });
+
+    parallelFor(numEdges, numThreads, [&](int begin, int last) {
+        for(int i = begin; i < last; i++) {
+            if (E[i].w == 0) E[i].w = edgeWeight(drawn, E[i].v1, E[i].v2);
+            ids[i] = i;
+        }
+    });
+
+    /* Sorts the edges, keeping the lightest of the parallel ones */
+    int minWeight = 0
+    ,   maxWeight = 0;
+
+    isa().weightRange(E, numEdges, &minWeight, &maxWeight);
+    radixSortEdges(E, ids, numEdges, numVertices, minWeight, maxWeight, tmpE, tmpIds, numThreads);
+    numEdges = uniqueEdges(E, ids, numEdges, tmpE, tmpIds, numThreads);
+    std::swap(E, tmpE);
+
+    delete [] tmpE;
+    delete [] ids;
+    delete [] tmpIds;
+
+    return TEXT_GRAPH_OK;
+}
+
+/* struct(ure) Input_Graph holds the graph of --input
+*
+*  mapped => the binary graph file, mapped in place (base is NULL for a
+*            text file)
+*  edges => the edge list, in the mapping or parsed into memory
+*  description => what was read, or why it failed
+*  ms => time it took to map or parse
+*/
+struct Input_Graph {
+    Mapped_Graph mapped;
+    Edge* edges;
+    int numVertices
+    ,   numEdges;
+    char description[256];
+    double ms;
+};
+
+/* Reads the graph of options.input - a binary graph file or a text one
+*
+*  returns false on error, graph.description says why
+*/
+inline bool loadInputGraph(const Generator_Options &options, int numThreads, Input_Graph &graph) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const char* path = options.input;
+
+    memset(&graph, 0, sizeof(graph));
+
+    Graph_File_Status status = mapGraphFile(path, graph.mapped);
+
+    if (status == GRAPH_FILE_OK && options.verify) {
+        status = checkGraphArrays(graph.mapped, numThreads);
+        if (status != GRAPH_FILE_OK) unmapGraphFile(graph.mapped);
+    }
+
+    if (status == GRAPH_FILE_OK) {
+        graph.edges = graph.mapped.edges;
+        graph.numVertices = graph.mapped.numVertices;
+        graph.numEdges = graph.mapped.numEdges;
+        snprintf(graph.description, sizeof(graph.description), "binary graph file, mapped");
+    } else if (status != GRAPH_FILE_MAGIC_MISMATCH) {
+        snprintf(graph.description, sizeof(graph.description), "%s: %s", path,
+                 graphFileStatusNames[status]);
+        return false;
+    } else {
+#ifdef __linux__
+        /* Not a binary graph file, parses it as text */
+        int fd = open(path, O_RDONLY);
+        struct stat info;
+        void* base = MAP_FAILED;
+
+        if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+            base = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (fd >= 0) close(fd);
+        if (base == MAP_FAILED) {
+            bool empty = fd >= 0 && info.st_size == 0;
+
+            snprintf(graph.description, sizeof(graph.description), "%s: %s", path,
+                     textGraphStatusNames[empty ? TEXT_GRAPH_FORMAT : TEXT_GRAPH_OPEN]);
+            return false;
+        }
+
+        /* The chunks are read front to back, once */
+        madvise(base, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+        Text_Format format = TEXT_SNAP;
+        long long errorLine = 0;
+        Text_Graph_Status result = parseTextGraph((const char*) base, (size_t) info.st_size,
+                                                  options, numThreads, graph.edges,
+                                                  graph.numEdges, graph.numVertices,
+                                                  format, errorLine);
+
+        munmap(base, (size_t) info.st_size);
+        if (result != TEXT_GRAPH_OK) {
+            if (errorLine > 0)
+                snprintf(graph.description, sizeof(graph.description), "%s:%lld: %s", path,
+                         errorLine, textGraphStatusNames[result]);
+            else
+                snprintf(graph.description, sizeof(graph.description), "%s: %s", path,
+                         textGraphStatusNames[result]);
+            delete [] graph.edges;
+            graph.edges = NULL;
+            return false;
+        }
+
+        snprintf(graph.description, sizeof(graph.description), "%s text, parsed",
+                 textFormatNames[format]);
+#else
+        snprintf(graph.description, sizeof(graph.description), "%s: %s", path,
+                 textGraphStatusNames[TEXT_GRAPH_OPEN]);
+        return false;
+#endif
+    }
+
+    graph.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()
+                                                         - start).count();
+    return true;
+}
+
+/* The CSR form of the input at hand, NULL if it has to be built */
+inline const CSR_Graph* inputCSR(const Input_Graph &graph) {
+    return graph.mapped.base != NULL && graph.mapped.csr.edgeIds != NULL ? &graph.mapped.csr
+                                                                         : NULL;
+}
+
+/* Releases the graph of --input */
+inline void freeInputGraph(Input_Graph &graph) {
+    if (graph.mapped.base != NULL)
+        unmapGraphFile(graph.mapped);
+    else
+        delete [] graph.edges;
+
+    graph.edges = NULL;
+}
+
+#endif
@@ -0,0 +1,301 @@
+/* thread_pool.h
+*
+*  Work-stealing thread pool behind every host-side parallel loop. Each
+*  worker owns a Chase-Lev deque of range tasks: it splits its range in
+*  halves, pushes the upper halves to the bottom of its own deque and
+*  keeps working on the lower one, while idle workers steal the largest
+*  pending halves from the top of the others' deques. The calling thread
+*  takes part as worker 0, so a pool of N threads starts N - 1 of them.
+*
+*  Only one loop runs on the pool at a time; loops started from inside a
+*  loop body run serially on the calling worker.
+*
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* Capacity of a deque - splitting in halves needs one slot per level */
+#define DEQUE_CAPACITY 1024
+
+/* struct(ure) Range_Task holds a piece of a parallel loop
+*
+*  invoke, body => type-erased loop body, called as body(begin, end)
+*  begin, end => range of the piece
+*  grain => pieces of at most this many elements are not split further
+*  remaining => elements of the loop not done yet
+*/
+struct Range_Task {
+    void (*invoke)(void* body, int begin, int end);
+    void* body;
+    int begin
+    ,   end
+    ,   grain;
+    std::atomic<int>* remaining;
+};
+
+/* struct(ure) Work_Deque is a Chase-Lev deque of tasks: the owner pushes
+*  and pops at the bottom, thieves steal from the top
+*/
+struct Work_Deque {
+    std::atomic<int64_t> top
+    ,                    bottom;
+    std::atomic<Range_Task*> tasks[DEQUE_CAPACITY];
+};
+
+/* Pushes a task at the bottom, owner only - false if the deque is full */
+inline bool PushTask(Work_Deque &deque, Range_Task* task) {
+    int64_t b = deque.bottom.load();
+    int64_t t = deque.top.load();
+
+    if (b - t >= DEQUE_CAPACITY) return false;
+
+    deque.tasks[b % DEQUE_CAPACITY].store(task);
+    deque.bottom.store(b + 1);
+    return true;
+}
+
+/* Pops the newest task from the bottom, owner only - NULL if empty */
+inline Range_Task* PopTask(Work_Deque &deque) {
+    int64_t b = deque.bottom.load() - 1;
+    deque.bottom.store(b);
+    int64_t t = deque.top.load();
+
+    if (t > b) {
+        deque.bottom.store(b + 1);
+        return NULL;
+    }
+
+    Range_Task* task = deque.tasks[b % DEQUE_CAPACITY].load();
+
+    /* Last task - races with the thieves for it */
+    if (t == b) {
+        if (!deque.top.compare_exchange_strong(t, t + 1)) task = NULL;
+        deque.bottom.store(b + 1);
+    }
+
+    return task;
+}
+
+/* Steals the oldest task from the top - NULL if empty or lost the race */
+inline Range_Task* StealTask(Work_Deque &deque) {
+    int64_t t = deque.top.load();
+    int64_t b = deque.bottom.load();
+
+    if (t >= b) return NULL;
+
+    Range_Task* task = deque.tasks[t % DEQUE_CAPACITY].load();
+    if (!deque.top.compare_exchange_strong(t, t + 1)) return NULL;
+
+    return task;
+}
+
+/* struct(ure) Thread_Pool holds the workers and their deques
+*
+*  numThreads => workers including the calling thread (worker 0)
+*  deques => one per worker
+*  activeLoops => raised while a loop runs, workers sleep otherwise
+*  loopMutex => lets one loop at a time run on the pool
+*/
+struct Thread_Pool {
+    int numThreads;
+    bool pinned;
+    std::vector<std::thread> threads;
+    Work_Deque* deques;
+    std::atomic<int> activeLoops;
+    std::atomic<bool> stopping;
+    std::mutex sleepMutex
+    ,          loopMutex;
+    std::condition_variable wakeUp;
+};
+
+/* Index of the pool worker running on this thread, -1 outside the pool */
+inline int &currentWorker() {
+    static thread_local int worker = -1;
+
+    return worker;
+}
+
+/* Pins the calling thread to one core */
+inline void PinThread(int core) {
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(core % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) core;
+#endif
+}
+
+/* Runs a task, splitting off the upper halves for the thieves */
+inline void RunTask(Thread_Pool &pool, int worker, Range_Task* task) {
+    while (task->end - task->begin > task->grain) {
+        int mid = task->begin + (task->end - task->begin) / 2;
+        Range_Task* half = new Range_Task(*task);
+
+        half->begin = mid;
+        if (!PushTask(pool.deques[worker], half)) {
+            delete half;
+            break;
+        }
+        task->end = mid;
+    }
+
+    task->invoke(task->body, task->begin, task->end);
+    task->remaining->fetch_sub(task->end - task->begin);
+    delete task;
+}
+
+/* Finds work: own deque first, then the others from a random victim on */
+inline Range_Task* FindTask(Thread_Pool &pool, int worker, uint32_t &seed) {
+    Range_Task* task = PopTask(pool.deques[worker]);
+    if (task != NULL) return task;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    for (int k = 0; k < pool.numThreads; k++) {
+        int victim = (int) ((seed + k) % pool.numThreads);
+
+        if (victim == worker) continue;
+        task = StealTask(pool.deques[victim]);
+        if (task != NULL) return task;
+    }
+
+    return NULL;
+}
+
+/* Main loop of a pool thread */
+inline void WorkerLoop(Thread_Pool &pool, int worker) {
+    uint32_t seed = 2654435761u * (worker + 1);
+
+    currentWorker() = worker;
+    if (pool.pinned) PinThread(worker);
+
+    for (;;) {
+        Range_Task* task = FindTask(pool, worker, seed);
+
+        if (task != NULL) {
+            RunTask(pool, worker, task);
+        } else if (pool.stopping.load()) {
+            return;
+        } else if (pool.activeLoops.load() > 0) {
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lock(pool.sleepMutex);
+            pool.wakeUp.wait(lock, [&pool] {
+                return pool.stopping.load() || pool.activeLoops.load() > 0;
+            });
+        }
+    }
+}
+
+/* Starts the workers of a pool
+*
+*  numThreads => workers including the calling thread
+*  pin => pins worker i to core i
+*/
+inline void StartPool(Thread_Pool &pool, int numThreads, bool pin) {
+    pool.numThreads = numThreads > 0 ? numThreads : 1;
+    pool.pinned = pin;
+    pool.deques = new Work_Deque[pool.numThreads];
+    pool.activeLoops.store(0);
+    pool.stopping.store(false);
+
+    for (int i = 0; i < pool.numThreads; i++) {
+        pool.deques[i].top.store(0);
+        pool.deques[i].bottom.store(0);
+    }
+
+    if (pin) PinThread(0);
+
+    for (int i = 1; i < pool.numThreads; i++)
+        pool.threads.push_back(std::thread(WorkerLoop, std::ref(pool), i));
+}
+
+/* Stops and joins the workers of a pool */
+inline void StopPool(Thread_Pool &pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.sleepMutex);
+        pool.stopping.store(true);
+    }
+    pool.wakeUp.notify_all();
+
+    for (size_t i = 0; i < pool.threads.size(); i++)
+        pool.threads[i].join();
+
+    pool.threads.clear();
+    delete [] pool.deques;
+    pool.deques = NULL;
+}
+
+/* Calls the body of a loop through its type-erased pointer */
+template <typename Body>
+void InvokeBody(void* body, int begin, int end) {
+    (*static_cast<Body*>(body))(begin, end);
+}
+
+/* Runs body(begin, end) over pieces of [0, n) on the pool, returns once
+*  every piece is done. The calling thread works on the loop as well.
+*
+*  grain => pieces of at most this many elements are not split further
+*/
+template <typename Body>
+void PoolParallelFor(Thread_Pool &pool, int n, int grain, Body &body) {
+    if (n <= 0) return;
+
+    /* Nested loops and single-threaded pools run serially */
+    if (pool.numThreads <= 1 || currentWorker() >= 0 || n <= grain) {
+        body(0, n);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(pool.loopMutex);
+    std::atomic<int> remaining(n);
+    Range_Task* root = new Range_Task;
+    uint32_t seed = 88172645u;
+
+    root->invoke = InvokeBody<Body>;
+    root->body = &body;
+    root->begin = 0;
+    root->end = n;
+    root->grain = grain > 0 ? grain : 1;
+    root->remaining = &remaining;
+
+    {
+        std::lock_guard<std::mutex> lock(pool.sleepMutex);
+        pool.activeLoops.store(1);
+    }
+    pool.wakeUp.notify_all();
+
+    currentWorker() = 0;
+    RunTask(pool, 0, root);
+
+    while (remaining.load() > 0) {
+        Range_Task* task = FindTask(pool, 0, seed);
+
+        if (task != NULL) RunTask(pool, 0, task);
+        else std::this_thread::yield();
+    }
+
+    currentWorker() = -1;
+    pool.activeLoops.store(0);
+}
+
+#endif
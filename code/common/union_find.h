@@ -0,0 +1,82 @@
+/* union_find.h
+*
+*  Disjoint sets (union-find) over the vertices 0..n-1, stored as two
+*  contiguous arrays - 8 bytes per vertex.
+*
+*/
+
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <cstddef>
+#include <stdint.h>
+
+/* struct(ure) Union_Find holds the forest of the disjoint sets
+*
+*  numElements => number of elements (vertices)
+*  parent => parent of each element, roots point to themselves
+*  size => number of elements under each root - used for linking
+*/
+struct Union_Find {
+    int numElements;
+    uint32_t* parent;
+    uint32_t* size;
+};
+
+/* Creates the sets - one per element */
+inline Union_Find MakeSets(int numElements) {
+    Union_Find uf;
+
+    uf.numElements = numElements;
+    uf.parent = new uint32_t[numElements];
+    uf.size = new uint32_t[numElements];
+
+    for(int i = 0; i < numElements; i++) {
+        uf.parent[i] = i;
+        uf.size[i] = 1;
+    }
+
+    return uf;
+}
+
+/* Finds the root of the element, halving the path on the way up */
+inline uint32_t Find(Union_Find &uf, uint32_t x) {
+    while (uf.parent[x] != x) {
+        uf.parent[x] = uf.parent[uf.parent[x]];
+        x = uf.parent[x];
+    }
+
+    return x;
+}
+
+/* Merges the sets of two elements, the smaller one goes under the larger
+*
+*  returns false if they already were in the same set
+*/
+inline bool Union(Union_Find &uf, uint32_t x, uint32_t y) {
+    uint32_t root1 = Find(uf, x);
+    uint32_t root2 = Find(uf, y);
+
+    if (root1 == root2) return false;
+
+    if (uf.size[root1] < uf.size[root2]) {
+        uint32_t temp = root1;
+        root1 = root2;
+        root2 = temp;
+    }
+
+    uf.parent[root2] = root1;
+    uf.size[root1] += uf.size[root2];
+
+    return true;
+}
+
+/* Releases the arrays of the sets */
+inline void FreeSets(Union_Find &uf) {
+    delete [] uf.parent;
+    delete [] uf.size;
+
+    uf.parent = uf.size = NULL;
+}
+
+#endif
@@ -2,24 +2,388 @@ struct Edge {
     int v1, v2, w;  // vertex 1, vertex 2, weight makes a complete connection
 };
 
-__kernel void findMinEdge(__global struct Edge *EI, __global struct Edge *EO, __global int* numEdges)
+#define NO_EDGE 0x7fffffff
+
+/* Finds the minimum outgoing edge of every vertex over its own CSR slice
+*  and folds its weight into the vertex's component
+*
+*  offsets, neighbors, weights, edgeIds => CSR graph (dead entries are -1)
+*  vertexMinEdge => minimum edge of each vertex (-1 if none)
+*  minWeight => minimum edge weight of each component
+*/
+__kernel void findMinEdge(__global int *offsets, __global int *neighbors,
+                          __global int *weights, __global int *edgeIds,
+                          __global int *parent, __global int *vertexMinEdge,
+                          __global int *minWeight)
 {
     int gid = get_global_id(0);
-    int c = gid, min = 9999, index = -1;
+    int index = -1, min = NO_EDGE;
+
+    for (int k = offsets[gid]; k < offsets[gid + 1]; k++) {
+        if (neighbors[k] == -1) continue;
 
-    for(int j = 0; j < numEdges; j++) {
-        if(EI[j].v1 == gid && EI[j].w <= min){
-            min = EI[j].w;
-            index = j;
+        if (weights[k] < min || (weights[k] == min && edgeIds[k] < index)) {
+            min = weights[k];
+            index = edgeIds[k];
         }
+    }
+
+    vertexMinEdge[gid] = index;
+    if (index != -1)
+        atomic_min(&minWeight[parent[gid]], min);
+}
+
+/* Picks the minimum edge of every component among its vertices' minimum
+*  edges, ties on the weight go to the smaller edge index
+*/
+__kernel void selectMinEdge(__global struct Edge *EI, __global int *parent,
+                            __global int *vertexMinEdge, __global int *minWeight,
+                            __global int *minEdge)
+{
+    int gid = get_global_id(0);
+    int index = vertexMinEdge[gid];
+    int c = parent[gid];
+
+    if (index != -1 && EI[index].w == minWeight[c])
+        atomic_min(&minEdge[c], index);
+}
+
+#ifdef cl_khr_int64_extended_atomics
+#pragma OPENCL EXTENSION cl_khr_int64_extended_atomics : enable
+
+/* Packs (weight, edge index) into a key that orders the same way, the
+*  sign bit of the weight is flipped so negative weights sort first
+*/
+ulong packEdgeKey(int w, int index)
+{
+    return ((ulong)((uint)w ^ 0x80000000) << 32) | (uint)index;
+}
+
+/* Finds the minimum outgoing edge of every component - one work-item
+*  per edge, folding its packed key into both endpoints' components
+*
+*  EI => live edges, endpoints are component labels (see compactEdges)
+*/
+__kernel void findMinEdgeKey(__global struct Edge *EI, __global ulong *minKey)
+{
+    int gid = get_global_id(0);
+    int c1 = EI[gid].v1;
+    int c2 = EI[gid].v2;
+
+    if (c1 == c2) return;
+
+    ulong key = packEdgeKey(EI[gid].w, gid);
+    atom_min(&minKey[c1], key);
+    atom_min(&minKey[c2], key);
+}
+
+/* Unpacks the minimum key of every component into its edge index and
+*  resets the key for the next round
+*/
+__kernel void unpackMinEdge(__global ulong *minKey, __global int *minEdge)
+{
+    int gid = get_global_id(0);
+
+    minEdge[gid] = (minKey[gid] == ULONG_MAX) ? NO_EDGE : (int)(minKey[gid] & 0xffffffff);
+    minKey[gid] = ULONG_MAX;
+}
+#endif
+
+/* Edge-parallel fallback for devices without 64-bit atomics: folds the
+*  weight of every edge into both endpoints' components
+*/
+__kernel void findMinWeightPerEdge(__global struct Edge *EI, __global int *minWeight)
+{
+    int gid = get_global_id(0);
+    int c1 = EI[gid].v1;
+    int c2 = EI[gid].v2;
+
+    if (c1 == c2) return;
+
+    atomic_min(&minWeight[c1], EI[gid].w);
+    atomic_min(&minWeight[c2], EI[gid].w);
+}
+
+/* Second pass of the fallback: the edges matching their component's
+*  minimum weight settle the tie on the smallest edge index
+*/
+__kernel void selectMinEdgePerEdge(__global struct Edge *EI, __global int *minWeight,
+                                   __global int *minEdge)
+{
+    int gid = get_global_id(0);
+    int c1 = EI[gid].v1;
+    int c2 = EI[gid].v2;
+
+    if (c1 == c2) return;
+
+    if (EI[gid].w == minWeight[c1]) atomic_min(&minEdge[c1], gid);
+    if (EI[gid].w == minWeight[c2]) atomic_min(&minEdge[c2], gid);
+}
+
+/* Hooks every component onto the component across its minimum edge,
+*  writing the new parents to successor so parent stays readable
+*
+*  Two components picking the same edge form the only possible cycle;
+*  the smaller label stays the root and the larger one records the
+*  edge's original index.
+*/
+__kernel void hookComponents(__global struct Edge *EI, __global int *ids,
+                             __global int *parent, __global int *minEdge,
+                             __global int *successor, __global int *mstEdges,
+                             __global int *mstCount)
+{
+    int gid = get_global_id(0);
+    int index = minEdge[gid];
+
+    successor[gid] = parent[gid];
+    if (parent[gid] != gid || index == NO_EDGE) return;
+
+    int s = (parent[EI[index].v1] == gid) ? parent[EI[index].v2] : parent[EI[index].v1];
+    if (minEdge[s] == index && gid < s) return;
+
+    successor[gid] = s;
+    mstEdges[atomic_inc(mstCount)] = ids[index];
+}
+
+/* Shortcuts every vertex to its grandparent, raising changed if any
+*  vertex wasn't pointing at its root yet
+*/
+__kernel void jumpPointers(__global int *parent, __global int *changed)
+{
+    int gid = get_global_id(0);
+    int p = parent[gid];
+    int gp = parent[p];
+
+    if (p != gp) {
+        parent[gid] = gp;
+        *changed = 1;
+    }
+}
+
+/* Kills the CSR adjacency entries that ended up inside a single
+*  component, judged by the labels after hooking
+*/
+__kernel void filterEdges(__global int *offsets, __global int *neighbors,
+                          __global int *successor)
+{
+    int gid = get_global_id(0);
+    int c = successor[gid];
 
-        if(EI[j].v1 > gid) break;
+    for (int k = offsets[gid]; k < offsets[gid + 1]; k++) {
+        if (neighbors[k] != -1 && successor[neighbors[k]] == c)
+            neighbors[k] = -1;
     }
+}
 
-    if(index != -1){
-        EO[c].v1 = gid;
-        EO[c].v2 = EI[index].v2;
-        EO[c].w = EI[index].w;
-        c++;
+/* Takes on the new component labels and resets the vertex's component
+*  minimum for the next round
+*/
+__kernel void relabelVertices(__global int *parent, __global int *successor,
+                              __global int *minWeight, __global int *minEdge)
+{
+    int gid = get_global_id(0);
+
+    parent[gid] = successor[gid];
+    minWeight[gid] = NO_EDGE;
+    minEdge[gid] = NO_EDGE;
+}
+
+/* Flags the edges whose endpoints are still in different components */
+__kernel void markLiveEdges(__global struct Edge *EI, __global int *parent,
+                            __global int *flags)
+{
+    int gid = get_global_id(0);
+
+    flags[gid] = (parent[EI[gid].v1] != parent[EI[gid].v2]) ? 1 : 0;
+}
+
+/* Stream compaction of the live edges: moves every one of them to its
+*  scanned position, rewriting its endpoints to component labels (the
+*  smaller one first) and keeping its original index alongside
+*
+*  positions => exclusive scan of the markLiveEdges flags
+*/
+__kernel void compactEdges(__global struct Edge *EI, __global int *ids,
+                           __global int *parent, __global int *positions,
+                           __global struct Edge *EO, __global int *idsOut)
+{
+    int gid = get_global_id(0);
+    int c1 = parent[EI[gid].v1];
+    int c2 = parent[EI[gid].v2];
+
+    if (c1 == c2) return;
+
+    int pos = positions[gid];
+    EO[pos].v1 = min(c1, c2);
+    EO[pos].v2 = max(c1, c2);
+    EO[pos].w = EI[gid].w;
+    idsOut[pos] = ids[gid];
+}
+
+/* LSD radix sort of the edges by (v1, v2, weight), one digit per pass.
+*  Every work-item owns a contiguous run of itemsPerThread edges:
+*
+*  radixCount => counts the digits of its run into counts, laid out as
+*                counts[digit * threads + thread]
+*  radixScatter => after the exclusive scan of counts, moves its run to
+*                  the scanned offsets in order, so every pass is stable
+*
+*  field => 0 weight (sign bit flipped), 1 v2, 2 v1
+*/
+#define SORT_RADIX_BITS 4
+#define SORT_RADIX_BUCKETS (1 << SORT_RADIX_BITS)
+
+uint edgeSortKey(__global struct Edge *edge, int field)
+{
+    if (field == 0) return (uint)edge->w ^ 0x80000000;
+    if (field == 1) return (uint)edge->v2;
+
+    return (uint)edge->v1;
+}
+
+__kernel void radixCount(__global struct Edge *EI, int n, int field, int shift,
+                         int itemsPerThread, __global int *counts)
+{
+    int gid = get_global_id(0);
+    int threads = get_global_size(0);
+    int first = gid * itemsPerThread;
+    int last = min(first + itemsPerThread, n);
+    int digitCounts[SORT_RADIX_BUCKETS];
+
+    for (int b = 0; b < SORT_RADIX_BUCKETS; b++)
+        digitCounts[b] = 0;
+
+    for (int i = first; i < last; i++)
+        digitCounts[(edgeSortKey(&EI[i], field) >> shift) & (SORT_RADIX_BUCKETS - 1)]++;
+
+    for (int b = 0; b < SORT_RADIX_BUCKETS; b++)
+        counts[b * threads + gid] = digitCounts[b];
+}
+
+__kernel void radixScatter(__global struct Edge *EI, __global int *ids, int n, int field,
+                           int shift, int itemsPerThread, __global int *offsets,
+                           __global struct Edge *EO, __global int *idsOut)
+{
+    int gid = get_global_id(0);
+    int threads = get_global_size(0);
+    int first = gid * itemsPerThread;
+    int last = min(first + itemsPerThread, n);
+    int digitOffsets[SORT_RADIX_BUCKETS];
+
+    for (int b = 0; b < SORT_RADIX_BUCKETS; b++)
+        digitOffsets[b] = offsets[b * threads + gid];
+
+    for (int i = first; i < last; i++) {
+        int pos = digitOffsets[(edgeSortKey(&EI[i], field) >> shift) & (SORT_RADIX_BUCKETS - 1)]++;
+        EO[pos] = EI[i];
+        idsOut[pos] = ids[i];
     }
-}
\ No newline at end of file
+}
+
+/* Whether the sorted edge starts a run of parallel edges */
+int isSegmentHead(__global struct Edge *EI, int i)
+{
+    return i == 0 || EI[i].v1 != EI[i - 1].v1 || EI[i].v2 != EI[i - 1].v2;
+}
+
+/* Segmented unique of the sorted edges, keeps the first (lightest) edge
+*  of every run:
+*
+*  markSegmentHeads => flags the first edge of every run
+*  gatherSegmentHeads => moves the flagged edges to their scanned positions
+*/
+__kernel void markSegmentHeads(__global struct Edge *EI, __global int *flags)
+{
+    int gid = get_global_id(0);
+
+    flags[gid] = isSegmentHead(EI, gid);
+}
+
+__kernel void gatherSegmentHeads(__global struct Edge *EI, __global int *ids,
+                                 __global int *positions, __global struct Edge *EO,
+                                 __global int *idsOut)
+{
+    int gid = get_global_id(0);
+
+    if (!isSegmentHead(EI, gid)) return;
+
+    EO[positions[gid]] = EI[gid];
+    idsOut[positions[gid]] = ids[gid];
+}
+
+/* Counts the components (roots) remaining */
+__kernel void countComponents(__global int *parent, __global int *components)
+{
+    int gid = get_global_id(0);
+
+    if (parent[gid] == gid)
+        atomic_inc(components);
+}
+
+/* Work-efficient (Blelloch) exclusive scan, one set of Kernels per
+*  element type:
+*
+*  scanBlocks_T => every work-group scans 2 * local size elements in
+*                  local memory and writes the block total to blockSums
+*  addBlockSums_T => adds the scanned block totals back to every block
+*
+*  Larger arrays scan the block totals recursively, see device_scan.h.
+*/
+#define DEFINE_SCAN_KERNELS(T)                                              \
+__kernel void scanBlocks_##T(__global T *data, __global T *blockSums,      \
+                             __local T *temp, int n)                        \
+{                                                                           \
+    int lid = get_local_id(0);                                              \
+    int size = 2 * get_local_size(0);                                       \
+    int base = get_group_id(0) * size;                                      \
+    int offset = 1;                                                         \
+                                                                            \
+    temp[2 * lid] = (base + 2 * lid < n) ? data[base + 2 * lid] : 0;        \
+    temp[2 * lid + 1] = (base + 2 * lid + 1 < n) ? data[base + 2 * lid + 1] : 0; \
+                                                                            \
+    /* Up-sweep: builds the partial sums in place */                        \
+    for (int d = size >> 1; d > 0; d >>= 1) {                               \
+        barrier(CLK_LOCAL_MEM_FENCE);                                       \
+        if (lid < d) {                                                      \
+            int ai = offset * (2 * lid + 1) - 1;                            \
+            int bi = offset * (2 * lid + 2) - 1;                            \
+            temp[bi] += temp[ai];                                           \
+        }                                                                   \
+        offset *= 2;                                                        \
+    }                                                                       \
+                                                                            \
+    if (lid == 0) {                                                         \
+        blockSums[get_group_id(0)] = temp[size - 1];                        \
+        temp[size - 1] = 0;                                                 \
+    }                                                                       \
+                                                                            \
+    /* Down-sweep: turns the partial sums into an exclusive scan */         \
+    for (int d = 1; d < size; d *= 2) {                                     \
+        offset >>= 1;                                                       \
+        barrier(CLK_LOCAL_MEM_FENCE);                                       \
+        if (lid < d) {                                                      \
+            int ai = offset * (2 * lid + 1) - 1;                            \
+            int bi = offset * (2 * lid + 2) - 1;                            \
+            T t = temp[ai];                                                 \
+            temp[ai] = temp[bi];                                            \
+            temp[bi] += t;                                                  \
+        }                                                                   \
+    }                                                                       \
+    barrier(CLK_LOCAL_MEM_FENCE);                                           \
+                                                                            \
+    if (base + 2 * lid < n) data[base + 2 * lid] = temp[2 * lid];           \
+    if (base + 2 * lid + 1 < n) data[base + 2 * lid + 1] = temp[2 * lid + 1]; \
+}                                                                           \
+                                                                            \
+__kernel void addBlockSums_##T(__global T *data, __global T *blockSums,    \
+                               int blockElements)                           \
+{                                                                           \
+    int gid = get_global_id(0);                                             \
+                                                                            \
+    data[gid] += blockSums[gid / blockElements];                            \
+}
+
+DEFINE_SCAN_KERNELS(int)
+DEFINE_SCAN_KERNELS(uint)
+DEFINE_SCAN_KERNELS(long)
+DEFINE_SCAN_KERNELS(ulong)
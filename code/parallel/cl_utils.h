@@ -0,0 +1,182 @@
+/* cl_utils.h
+*
+*  OpenCL boilerplate shared by the programs in this folder: context,
+*  command queue and program creation, and Kernel launches.
+*
+*/
+
+#ifndef CL_UTILS_H
+#define CL_UTILS_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <CL/cl.h>
+
+/*  Creates an OpenCL context on the available platform using
+*  either a GPU or CPU depending on what is available
+*/
+inline cl_context CreateContext() {
+    /* Some variable's declarations */
+    cl_int errNum;
+    cl_uint numPlatforms;
+    cl_platform_id firstPlatformId;
+    cl_context context = NULL;
+
+    /*  Selects an (available) OpenCL platform to run on */
+    errNum = clGetPlatformIDs(1, &firstPlatformId, &numPlatforms);
+    if (errNum != CL_SUCCESS || numPlatforms <= 0) {
+        std::cerr << "Failed to find any OpenCL platforms." << std::endl;
+        return NULL;
+    }
+
+    /* Sets context properties */
+    cl_context_properties contextProperties[] = {
+        CL_CONTEXT_PLATFORM,
+        (cl_context_properties)firstPlatformId,
+        0
+    };
+    
+    /* Creates an OpenCL context on the platform */
+    context = clCreateContextFromType(contextProperties, CL_DEVICE_TYPE_CPU,
+                                        NULL, NULL, &errNum);
+    if (errNum != CL_SUCCESS) {
+        std::cout << "Could not create GPU context, trying CPU..." << std::endl;
+        context = clCreateContextFromType(contextProperties, CL_DEVICE_TYPE_CPU,
+                                            NULL, NULL, &errNum);
+        if (errNum != CL_SUCCESS) {
+            std::cerr << "Failed to create an OpenCL GPU or CPU context." << std::endl;
+            return NULL;
+        }
+    }
+
+    return context;
+}
+
+/* Creates a command queue on the device available on the context */
+inline cl_command_queue CreateCommandQueue(cl_context context, cl_device_id *device) {
+    cl_int errNum;
+    cl_device_id *devices;
+    cl_command_queue commandQueue = NULL;
+    size_t deviceBufferSize = -1;
+
+    /* Gets the size of the devices buffer */
+    errNum = clGetContextInfo(context, CL_CONTEXT_DEVICES, 0, NULL, &deviceBufferSize);
+    if (errNum != CL_SUCCESS) {
+        std::cerr << "Failed call to clGetContextInfo(...,GL_CONTEXT_DEVICES,...)";
+        return NULL;
+    }
+
+    if (deviceBufferSize <= 0) {
+        std::cerr << "No devices available.";
+        return NULL;
+    }
+
+    /* Allocates memory for the devices buffer */
+    devices = new cl_device_id[deviceBufferSize / sizeof(cl_device_id)];
+    errNum = clGetContextInfo(context, CL_CONTEXT_DEVICES, deviceBufferSize, devices, NULL);
+    if (errNum != CL_SUCCESS) {
+        delete [] devices;
+        std::cerr << "Failed to get device IDs";
+        return NULL;
+    }
+
+    /* Sets command queue properties */
+    cl_command_queue_properties cmdQProperties = {
+        CL_QUEUE_PROFILING_ENABLE
+    };
+
+    /* Chooses the first available device */
+    commandQueue = clCreateCommandQueue(context, devices[0], cmdQProperties, NULL);
+    if (commandQueue == NULL) {
+        delete [] devices;
+        std::cerr << "Failed to create commandQueue for device 0";
+        return NULL;
+    }
+
+    *device = devices[0];
+    delete [] devices;
+    return commandQueue;
+}
+
+/* Checks whether the device supports an OpenCL extension */
+inline bool HasExtension(cl_device_id device, const char* extension) {
+    size_t size = 0;
+
+    if (clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, 0, NULL, &size) != CL_SUCCESS)
+        return false;
+
+    char* extensions = new char[size + 1];
+    clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, size, extensions, NULL);
+    extensions[size] = '\0';
+
+    bool found = strstr(extensions, extension) != NULL;
+    delete [] extensions;
+
+    return found;
+}
+
+/* Create an OpenCL program from the Kernel source file */
+inline cl_program CreateProgram(cl_context context, cl_device_id device, const char* fileName) {
+    cl_int errNum;
+    cl_program program;
+
+    std::ifstream kernelFile(fileName, std::ios::in);
+    if (!kernelFile.is_open()) {
+        std::cerr << "Failed to open file for reading: " << fileName << std::endl;
+        return NULL;
+    }
+
+    std::ostringstream oss;
+    oss << kernelFile.rdbuf();
+
+    std::string srcStdStr = oss.str();
+    const char *srcStr = srcStdStr.c_str();
+
+    program = clCreateProgramWithSource(context, 1, (const char**)&srcStr, NULL, NULL);
+    if (program == NULL) {
+        std::cerr << "Failed to create CL program from source." << std::endl;
+        return NULL;
+    }
+
+    errNum = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    if (errNum != CL_SUCCESS) {
+        /* Gets program's errors */
+        char buildLog[16384];
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG,
+                                sizeof(buildLog), buildLog, NULL);
+
+        std::cerr << "Error in Kernel: " << std::endl;
+        std::cerr << buildLog;
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+/* Queues a Kernel up for execution over a 1D range of work-items
+*
+*  localSize => work-group size, 0 lets the runtime pick one
+*/
+inline bool EnqueueKernel(cl_command_queue commandQueue, cl_kernel kernel, size_t size,
+                          cl_event* event, size_t localSize = 0) {
+    size_t globalWorkSize[1] = { size };
+    size_t localWorkSize[1] = { localSize };
+
+    if (size == 0) return true;
+
+    cl_int errNum = clEnqueueNDRangeKernel(commandQueue, kernel, 1, NULL,
+                                           globalWorkSize, localSize ? localWorkSize : NULL,
+                                           0, NULL, event);
+    if (errNum != CL_SUCCESS) {
+        std::cerr << "Error queuing Kernel for execution." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#endif
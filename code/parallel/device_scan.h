@@ -0,0 +1,202 @@
+/* device_scan.h
+*
+*  Exclusive prefix sum (scan) of an OpenCL buffer, built on the
+*  scanBlocks_T / addBlockSums_T Kernels of _kernel.cl. Every level scans
+*  blocks of 2 * localSize elements and the block totals are scanned
+*  recursively until they fit into a single block.
+*
+*/
+
+#ifndef DEVICE_SCAN_H
+#define DEVICE_SCAN_H
+
+#include <iostream>
+#include <string>
+#include <CL/cl.h>
+
+#include "cl_utils.h"
+
+/* Preprocessor Directives */
+#define MAX_SCAN_LEVELS 8
+#define SCAN_BLOCK_SIZE 256
+
+/* Element types the scan Kernels are built for */
+enum Scan_Type {
+    SCAN_INT,
+    SCAN_UINT,
+    SCAN_LONG,
+    SCAN_ULONG,
+    NUM_SCAN_TYPES
+};
+
+const char* const scanTypeNames[NUM_SCAN_TYPES] = { "int", "uint", "long", "ulong" };
+const size_t scanTypeSizes[NUM_SCAN_TYPES] = {
+    sizeof(cl_int), sizeof(cl_uint), sizeof(cl_long), sizeof(cl_ulong)
+};
+
+/* struct(ure) Device_Scan holds everything a scan of up to maxElements needs
+*
+*  scanKernels, addKernels => Kernels of every element type
+*  levels => block totals of every level, sized for 64-bit elements
+*  localSize => work-group size, every group scans 2 * localSize elements
+*/
+struct Device_Scan {
+    cl_kernel scanKernels[NUM_SCAN_TYPES];
+    cl_kernel addKernels[NUM_SCAN_TYPES];
+    cl_mem levels[MAX_SCAN_LEVELS];
+    int numLevels
+    ,   maxElements;
+    size_t localSize;
+};
+
+/* Releases the Kernels and buffers of a scan */
+inline void ReleaseDeviceScan(Device_Scan &scan) {
+    for (int i = 0; i < NUM_SCAN_TYPES; i++) {
+        if (scan.scanKernels[i] != 0) clReleaseKernel(scan.scanKernels[i]);
+        if (scan.addKernels[i] != 0) clReleaseKernel(scan.addKernels[i]);
+        scan.scanKernels[i] = scan.addKernels[i] = 0;
+    }
+
+    for (int i = 0; i < scan.numLevels; i++) {
+        if (scan.levels[i] != 0) clReleaseMemObject(scan.levels[i]);
+        scan.levels[i] = 0;
+    }
+
+    scan.numLevels = 0;
+}
+
+/* Creates the Kernels and the block totals buffers of a scan */
+inline bool CreateDeviceScan(cl_context context, cl_program program, cl_device_id device,
+                             int maxElements, Device_Scan &scan) {
+    size_t maxWorkGroupSize = SCAN_BLOCK_SIZE;
+
+    for (int i = 0; i < NUM_SCAN_TYPES; i++)
+        scan.scanKernels[i] = scan.addKernels[i] = 0;
+    scan.numLevels = 0;
+    scan.maxElements = maxElements;
+
+    /* Work-group size has to be a power of two */
+    clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t),
+                    &maxWorkGroupSize, NULL);
+    scan.localSize = 1;
+    while (scan.localSize * 2 <= SCAN_BLOCK_SIZE && scan.localSize * 2 <= maxWorkGroupSize)
+        scan.localSize *= 2;
+
+    for (int i = 0; i < NUM_SCAN_TYPES; i++) {
+        std::string scanName = std::string("scanBlocks_") + scanTypeNames[i];
+        std::string addName = std::string("addBlockSums_") + scanTypeNames[i];
+
+        scan.scanKernels[i] = clCreateKernel(program, scanName.c_str(), NULL);
+        scan.addKernels[i] = clCreateKernel(program, addName.c_str(), NULL);
+        if (scan.scanKernels[i] == NULL || scan.addKernels[i] == NULL) {
+            std::cerr << "Failed to create scan Kernels for " << scanTypeNames[i] << std::endl;
+            ReleaseDeviceScan(scan);
+            return false;
+        }
+    }
+
+    /* One buffer of block totals per level */
+    int n = maxElements > 0 ? maxElements : 1;
+    int blockElements = 2 * (int) scan.localSize;
+
+    for (;;) {
+        int blocks = (n + blockElements - 1) / blockElements;
+
+        if (scan.numLevels == MAX_SCAN_LEVELS) {
+            std::cerr << "Too many elements to scan." << std::endl;
+            ReleaseDeviceScan(scan);
+            return false;
+        }
+
+        scan.levels[scan.numLevels] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                     sizeof(cl_ulong) * blocks, NULL, NULL);
+        if (scan.levels[scan.numLevels++] == NULL) {
+            std::cerr << "Error creating scan buffers." << std::endl;
+            ReleaseDeviceScan(scan);
+            return false;
+        }
+
+        if (blocks == 1) break;
+        n = blocks;
+    }
+
+    return true;
+}
+
+/* Scans one level in place and recurses into its block totals
+*
+*  returns the buffer holding the grand total at index 0, NULL on error
+*/
+inline cl_mem ScanLevel(cl_command_queue commandQueue, Device_Scan &scan, Scan_Type type,
+                        cl_mem data, int n, int level) {
+    cl_int errNum;
+    int blockElements = 2 * (int) scan.localSize;
+    int blocks = (n + blockElements - 1) / blockElements;
+    cl_kernel scanKernel = scan.scanKernels[type];
+    cl_kernel addKernel = scan.addKernels[type];
+
+    errNum = clSetKernelArg(scanKernel, 0, sizeof(cl_mem), &data);
+    errNum |= clSetKernelArg(scanKernel, 1, sizeof(cl_mem), &scan.levels[level]);
+    errNum |= clSetKernelArg(scanKernel, 2, scanTypeSizes[type] * blockElements, NULL);
+    errNum |= clSetKernelArg(scanKernel, 3, sizeof(int), &n);
+    if (errNum != CL_SUCCESS) {
+        std::cerr << "Error setting scan Kernel arguments." << std::endl;
+        return NULL;
+    }
+
+    if (!EnqueueKernel(commandQueue, scanKernel, blocks * scan.localSize, NULL, scan.localSize))
+        return NULL;
+
+    if (blocks == 1)
+        return scan.levels[level];
+
+    cl_mem total = ScanLevel(commandQueue, scan, type, scan.levels[level], blocks, level + 1);
+    if (total == NULL) return NULL;
+
+    errNum = clSetKernelArg(addKernel, 0, sizeof(cl_mem), &data);
+    errNum |= clSetKernelArg(addKernel, 1, sizeof(cl_mem), &scan.levels[level]);
+    errNum |= clSetKernelArg(addKernel, 2, sizeof(int), &blockElements);
+    if (errNum != CL_SUCCESS) {
+        std::cerr << "Error setting scan Kernel arguments." << std::endl;
+        return NULL;
+    }
+
+    if (!EnqueueKernel(commandQueue, addKernel, n, NULL))
+        return NULL;
+
+    return total;
+}
+
+/* Exclusive scan of the first n elements of a buffer, in place
+*
+*  total => if not NULL, receives the sum of all n elements (one element
+*           of the scanned type, read back blocking)
+*/
+inline bool ScanDevice(cl_command_queue commandQueue, Device_Scan &scan, Scan_Type type,
+                       cl_mem data, int n, void* total) {
+    if (n > scan.maxElements) {
+        std::cerr << "Scan of " << n << " elements exceeds " << scan.maxElements << std::endl;
+        return false;
+    }
+
+    if (n <= 0) {
+        if (total != NULL) memset(total, 0, scanTypeSizes[type]);
+        return true;
+    }
+
+    cl_mem totalBuffer = ScanLevel(commandQueue, scan, type, data, n, 0);
+    if (totalBuffer == NULL) return false;
+
+    if (total != NULL) {
+        cl_int errNum = clEnqueueReadBuffer(commandQueue, totalBuffer, CL_TRUE, 0,
+                                            scanTypeSizes[type], total, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS) {
+            std::cerr << "Error reading scan total." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
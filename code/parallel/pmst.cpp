@@ -1,7 +1,17 @@
 /* pmst.cpp
 *
-*  The algorithm in this file is a (partially) parallel implementation of 
-*  Boruvka's algorithm to find Minimum Spanning Tree (MST) of a Graph.
+*  The algorithm in this file is a parallel implementation of Boruvka's
+*  algorithm to find Minimum Spanning Tree (MST) of a Graph. Every round
+*  (min-edge selection, hooking, pointer jumping and edge filtering) runs
+*  on the OpenCL device over the CSR form of the graph. The edge-parallel
+*  modes compact the edge list between the rounds and keep only the
+*  lightest of the parallel edges between two components (radix sort by
+*  endpoints and weight, then a segmented unique), so every round works
+*  on a simple graph of the edges still crossing two components. Once
+*  few components or live edges are left, the live edges are read back
+*  and the MST is finished on the Host by Kruskal or Prim, which spares
+*  the long tail of tiny rounds. Dense graphs skip the edge list and go
+*  to the dense engine, which works on the adjacency matrix itself.
 *
 */
 
@@ -11,122 +21,188 @@
 #include <sstream>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
+#include <chrono>
 #include <CL/cl.h>
 
+#include "../common/graph.h"
+#include "../common/matrix.h"
+#include "../common/radix_sort.h"
+#include "../common/cpu_boruvka.h"
+#include "../common/parallel.h"
+#include "../common/scan.h"
+#include "../common/isa_dispatch.h"
+#include "../common/finish_mst.h"
+#include "../common/dense_mst.h"
+#include "../common/random_graph.h"
+#include "../common/graph_file.h"
+#include "../common/text_graph.h"
+#include "../common/csr_build.h"
+#include "../common/compressed_graph.h"
+#include "../common/external_boruvka.h"
+#include "../common/mst_writer.h"
+#include "cl_utils.h"
+#include "device_scan.h"
+
 using namespace std;
 
 /* Preprocessor Directives */
 #define MAX_WEIGHT 50
-#define NUM_VERTICES 100
+#define DEFAULT_VERTICES 100
 #define ZERO 0
+#define NO_EDGE 0x7fffffff
+
+/* Device radix sort, see radixCount / radixScatter in _kernel.cl */
+#define SORT_RADIX_BITS 4
+#define SORT_RADIX_BUCKETS (1 << SORT_RADIX_BITS)
+#define SORT_ITEMS_PER_THREAD 32
 
 /* Global variables */
-int NUM_EDGES = ZERO
+int NUM_VERTICES = DEFAULT_VERTICES
+,   NUM_EDGES = ZERO
 ,   NUM_EDGES_MST = ZERO;
 
-/* struct(ure) Forest holds information about the edge 
-*  
-*  value => value of the node
-*  rank => rank of the node - used for linking
-*  parent => Forest_Node type node for maintaining tree hierarchy
-*/
+/* Memory objects used by the Boruvka pipeline */
+enum Mem_Object {
+    MEM_EDGES,          /* live edges, endpoints are component labels */
+    MEM_ORIGINAL_IDS,   /* original index of every live edge */
+    MEM_EDGES_OUT,      /* compaction target of MEM_EDGES */
+    MEM_ORIGINAL_IDS_OUT, /* compaction target of MEM_ORIGINAL_IDS */
+    MEM_LIVE_FLAGS,     /* live edge flags, scanned into positions */
+    MEM_SORT_COUNTS,    /* radix sort digit counts of every work-item */
+    MEM_OFFSETS,        /* CSR slice offsets */
+    MEM_NEIGHBORS,      /* CSR neighbors, -1 once inside a component */
+    MEM_WEIGHTS,        /* CSR weights */
+    MEM_EDGE_IDS,       /* CSR edge indices */
+    MEM_PARENT,         /* parent (component) of every vertex */
+    MEM_SUCCESSOR,      /* parent of every vertex after hooking */
+    MEM_VERTEX_MIN_EDGE, /* minimum outgoing edge of every vertex */
+    MEM_MIN_WEIGHT,     /* minimum outgoing edge weight of every component */
+    MEM_MIN_EDGE,       /* minimum outgoing edge of every component */
+    MEM_MIN_KEY,        /* packed (weight, edge) minimum of every component */
+    MEM_MST_EDGES,      /* indices of the MST edges */
+    MEM_MST_COUNT,      /* number of MST edges */
+    MEM_COMPONENTS,     /* number of components remaining */
+    MEM_CHANGED,        /* raised by a pointer jump that changed a label */
+    NUM_MEM_OBJECTS
+};
 
-struct Forest_Node {
-    int value
-    ,   rank;
-    struct Forest_Node* parent;
+/* Kernels of the Boruvka pipeline, see _kernel.cl */
+enum Kernel_Id {
+    KERNEL_FIND_MIN_EDGE,
+    KERNEL_SELECT_MIN_EDGE,
+    KERNEL_FIND_MIN_WEIGHT_PER_EDGE,
+    KERNEL_SELECT_MIN_EDGE_PER_EDGE,
+    KERNEL_HOOK,
+    KERNEL_JUMP,
+    KERNEL_FILTER,
+    KERNEL_RELABEL,
+    KERNEL_MARK_LIVE,
+    KERNEL_COMPACT,
+    KERNEL_RADIX_COUNT,
+    KERNEL_RADIX_SCATTER,
+    KERNEL_MARK_HEADS,
+    KERNEL_GATHER_HEADS,
+    KERNEL_COUNT,
+    KERNEL_FIND_MIN_EDGE_KEY,       /* needs cl_khr_int64_extended_atomics */
+    KERNEL_UNPACK_MIN_EDGE,         /* needs cl_khr_int64_extended_atomics */
+    NUM_KERNELS
 };
 
-/* Creates a list - one per element */
-Forest_Node* MakeSet(int value) {
-    Forest_Node* node = new Forest_Node;
+const char* kernelNames[NUM_KERNELS] = {
+    "findMinEdge", "selectMinEdge", "findMinWeightPerEdge", "selectMinEdgePerEdge",
+    "hookComponents", "jumpPointers", "filterEdges", "relabelVertices", "markLiveEdges",
+    "compactEdges", "radixCount", "radixScatter", "markSegmentHeads", "gatherSegmentHeads",
+    "countComponents",
+    "findMinEdgeKey", "unpackMinEdge"
+};
 
-    node->value = value;
-    node->parent = NULL;
-    node->rank = 0;
-    
-    return node;
-}
+/* Ways of finding the minimum outgoing edge of every component */
+enum Min_Edge_Mode {
+    MIN_EDGE_VERTEX,    /* one work-item per vertex over its CSR slice */
+    MIN_EDGE_EDGE,      /* one work-item per edge, packed 64-bit atom_min */
+    MIN_EDGE_EDGE32     /* one work-item per edge, two 32-bit atomic_min passes */
+};
 
-/* Finds the root of the node */
-Forest_Node* Find(Forest_Node* node) {
-    Forest_Node* temp;
-    Forest_Node* root = node;
-
-    while (root->parent != NULL)
-        root = root->parent;
-    
-    /* Updates the parent pointers */
-    while (node->parent != NULL) {
-        temp = node->parent;
-        node->parent = root;
-        node = temp;
-    }
-    
-    return root;
-}
+const char* minEdgeModeNames[] = {
+    "vertex-parallel", "edge-parallel (64-bit atomics)", "edge-parallel (32-bit atomics)"
+};
 
-/* Merges two nodes based on their rank */
-void Union(Forest_Node* node1, Forest_Node* node2) {
-    Forest_Node* root1 = Find(node1);
-    Forest_Node* root2 = Find(node2);
+/* Creates an adjacency matrix, rows are zeroed in parallel (so each
+*  row's pages are first touched by the thread that fills it)
+*
+*  hugePages => backs the matrix with huge pages where available
+*  data is NULL if the matrix can't be allocated
+*/
+Dense_Matrix createAdjacencyMatrix(int numThreads, bool hugePages) {
+    Dense_Matrix adjMatrix = createMatrix(NUM_VERTICES, NUM_VERTICES, hugePages);
+    if (adjMatrix.data == NULL) return adjMatrix;
 
-    if (root1->rank > root2->rank) { 
-        root2->parent = root1; 
-    } else if (root2->rank > root1->rank) { 
-        root1->parent = root2; 
-    } else {
-        root2->parent = root1; 
-        root1->rank++; 
-    }
+    /* Initializes all nodes (and the row padding) to ZERO */
+    parallelFor(NUM_VERTICES, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++)
+            memset(matrixRow(adjMatrix, i), 0, sizeof(int) * adjMatrix.stride);
+    });
+
+    return adjMatrix;
 }
 
-/* struct(ure) Edge holds information about the edge 
-*  
-*  v1 => vertex 1
-*  v2 => vertex 2
-*  w => weight of the edge
+/* Generates an adjacency matrix based random graph (fillMatrixGraph)
+*
+*  count => total (valid) edge count
+*  generator => seed (the same seed gives the same graph) and maxWeight
+*  data is NULL if the matrix can't be allocated
 */
-struct Edge {
-    int v1, v2, w;
-};
 
-/* Creates an adjacency matrix */
-int** createAdjacencyMatrix() {
-    int** adjMatrix = new int*[NUM_VERTICES];
+Dense_Matrix generateRandomGraph(int &count, const Generator_Options &generator, int numThreads,
+                                 bool hugePages) {
+    Dense_Matrix adjMatrix = createAdjacencyMatrix(numThreads, hugePages);
 
-    for(int i = 0; i < NUM_VERTICES; i++)
-        adjMatrix[i] = new int[NUM_VERTICES];
+    count = ZERO;
+    if (adjMatrix.data == NULL) return adjMatrix;
 
-    /* Initializes all nodes to ZERO */
-    for(int i = 0; i < NUM_VERTICES; i++)
-        for(int j = 0; j < NUM_VERTICES; j++)
-            adjMatrix[i][j] = 0;
+    count = fillMatrixGraph(adjMatrix, generator, numThreads);
 
     return adjMatrix;
 }
 
-/* Generates an adjacency matrix based random graph
-*
-*  count => total (valid) edge count
+/* Extracts the edges (j > i) of the adjacency matrix in row order - rows
+*  are counted, the counts scanned into offsets and filled in parallel
 */
+Edge* extractEdges(const Dense_Matrix &adjMatrix, int numEdges, int numThreads) {
+    Edge* ES = new Edge[numEdges];
+    int* rowOffsets = new int[NUM_VERTICES];
+
+    parallelFor(NUM_VERTICES, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            const int* row = matrixRow(adjMatrix, i);
 
-int** generateRandomGraph(int &count) {
-    int** adjMatrix = createAdjacencyMatrix();
-
-    srand(time(NULL));
-    for(int i = 0; i < NUM_VERTICES; i++) {
-        for(int j = 0; j < NUM_VERTICES; j++) {
-            if (i == j) continue;
-            adjMatrix[i][j] = (rand() % MAX_WEIGHT) - 1;
-            adjMatrix[j][i] = adjMatrix[i][j];
-            
-            if(adjMatrix[i][j] > 0)
-                count++;
+            rowOffsets[i] = 0;
+            for(int j = i + 1; j < NUM_VERTICES; j++)
+                rowOffsets[i] += row[j] > 0;
         }
-    }
+    });
+
+    exclusiveScan(rowOffsets, rowOffsets, NUM_VERTICES, numThreads);
+
+    parallelFor(NUM_VERTICES, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            const int* row = matrixRow(adjMatrix, i);
+            int c = rowOffsets[i];
+
+            for(int j = i + 1; j < NUM_VERTICES; j++) {
+                if(row[j] > 0 && c < numEdges) {
+                    ES[c].v1 = i;
+                    ES[c].v2 = j;
+                    ES[c].w = row[j];
+                    c++;
+                }
+            }
+        }
+    });
 
-    return adjMatrix;
+    delete [] rowOffsets;
+    return ES;
 }
 
 /* Displays edges list */
@@ -139,172 +215,564 @@ void displayEdgeList(Edge* E, int size) {
 }
 
 /* Displays adjacency matrix */
-void displayAdjacencyMatrix(int** adjMatrix) {
+void displayAdjacencyMatrix(const Dense_Matrix &adjMatrix) {
     cout << endl << "Adjacency Matrix [" << endl;
-    for(int i = 0; i < NUM_VERTICES; i++) {
+    for(int i = 0; i < adjMatrix.numRows; i++) {
+        const int* row = matrixRow(adjMatrix, i);
+
         cout << "\t{";
-        for(int j = 0; j < NUM_VERTICES; j++) {
-            cout << " " << adjMatrix[i][j] << " ";
+        for(int j = 0; j < adjMatrix.numCols; j++) {
+            cout << " " << row[j] << " ";
         }
         cout << "}" << endl;
     }
     cout << "]" << endl;
 }
 
-/*  Creates an OpenCL context on the available platform using
-*  either a GPU or CPU depending on what is available
+/* Number of digit counts of a radix sort pass over numEdges edges */
+int SortCountsSize(int numEdges) {
+    return SORT_RADIX_BUCKETS * ((numEdges + SORT_ITEMS_PER_THREAD - 1) / SORT_ITEMS_PER_THREAD);
+}
+
+/* Create memory objects to be used as arguments to the Kernels */
+bool CreateMemObjects(cl_context context, cl_mem memObjects[NUM_MEM_OBJECTS],
+                      Edge* EI, CSR_Graph &graph) {
+    int numVertices = graph.numVertices
+    ,   numEntries = 2 * graph.numEdges
+    ,   zero = ZERO;
+    int* parent = new int[numVertices];
+    int* noEdge = new int[numVertices];
+    cl_ulong* noKey = new cl_ulong[numVertices];
+    int* ids = new int[graph.numEdges];
+
+    /* Every vertex starts as its own component */
+    for(int i = 0; i < numVertices; i++) {
+        parent[i] = i;
+        noEdge[i] = NO_EDGE;
+        noKey[i] = CL_ULONG_MAX;
+    }
+
+    for(int i = 0; i < graph.numEdges; i++)
+        ids[i] = i;
+
+    memObjects[MEM_EDGES] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(Edge) * graph.numEdges, EI, NULL);
+    memObjects[MEM_ORIGINAL_IDS] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * graph.numEdges, ids, NULL);
+    memObjects[MEM_EDGES_OUT] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(Edge) * graph.numEdges, NULL, NULL);
+    memObjects[MEM_ORIGINAL_IDS_OUT] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * graph.numEdges, NULL, NULL);
+    memObjects[MEM_LIVE_FLAGS] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * graph.numEdges, NULL, NULL);
+    memObjects[MEM_SORT_COUNTS] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * SortCountsSize(graph.numEdges), NULL, NULL);
+    memObjects[MEM_OFFSETS] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * (numVertices + 1), graph.offsets, NULL);
+    memObjects[MEM_NEIGHBORS] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numEntries, graph.neighbors, NULL);
+    memObjects[MEM_WEIGHTS] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numEntries, graph.weights, NULL);
+    memObjects[MEM_EDGE_IDS] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numEntries, graph.edgeIds, NULL);
+    memObjects[MEM_PARENT] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numVertices, parent, NULL);
+    memObjects[MEM_SUCCESSOR] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * numVertices, NULL, NULL);
+    memObjects[MEM_VERTEX_MIN_EDGE] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * numVertices, NULL, NULL);
+    memObjects[MEM_MIN_WEIGHT] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numVertices, noEdge, NULL);
+    memObjects[MEM_MIN_EDGE] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * numVertices, noEdge, NULL);
+    memObjects[MEM_MIN_KEY] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(cl_ulong) * numVertices, noKey, NULL);
+    memObjects[MEM_MST_EDGES] = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                    sizeof(int) * numVertices, NULL, NULL);
+    memObjects[MEM_MST_COUNT] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * 1, &zero, NULL);
+    memObjects[MEM_COMPONENTS] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * 1, &zero, NULL);
+    memObjects[MEM_CHANGED] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    sizeof(int) * 1, &zero, NULL);
+
+    delete [] parent;
+    delete [] noEdge;
+    delete [] noKey;
+    delete [] ids;
+
+    for (int i = 0; i < NUM_MEM_OBJECTS; i++) {
+        if (memObjects[i] == NULL) {
+            cerr << "Error creating memory objects." << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Creates the Kernels of the Boruvka pipeline, the 64-bit atomics ones
+*  only exist in the program when the device supports them
+*/
+bool CreateKernels(cl_program program, cl_kernel kernels[NUM_KERNELS], bool int64Atomics) {
+    int numKernels = int64Atomics ? NUM_KERNELS : KERNEL_FIND_MIN_EDGE_KEY;
+
+    for (int i = 0; i < numKernels; i++) {
+        kernels[i] = clCreateKernel(program, kernelNames[i], NULL);
+        if (kernels[i] == NULL) {
+            cerr << "Failed to create Kernel " << kernelNames[i] << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Sets the Kernels' arguments - these stay the same until the edge
+*  buffers get swapped by a compaction
 */
-cl_context CreateContext() {
-    /* Some variable's declarations */
+bool SetKernelArgs(cl_kernel kernels[NUM_KERNELS], cl_mem memObjects[NUM_MEM_OBJECTS]) {
     cl_int errNum;
-    cl_uint numPlatforms;
-    cl_platform_id firstPlatformId;
-    cl_context context = NULL;
-
-    /*  Selects an (available) OpenCL platform to run on */
-    errNum = clGetPlatformIDs(1, &firstPlatformId, &numPlatforms);
-    if (errNum != CL_SUCCESS || numPlatforms <= ZERO) {
-        cerr << "Failed to find any OpenCL platforms." << endl;
-        return NULL;
-    }
-
-    /* Sets context properties */
-    cl_context_properties contextProperties[] = {
-        CL_CONTEXT_PLATFORM,
-        (cl_context_properties)firstPlatformId,
-        0
-    };
-    
-    /* Creates an OpenCL context on the platform */
-    context = clCreateContextFromType(contextProperties, CL_DEVICE_TYPE_CPU,
-                                        NULL, NULL, &errNum);
+
+    errNum = clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 0, sizeof(cl_mem), &memObjects[MEM_OFFSETS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 1, sizeof(cl_mem), &memObjects[MEM_NEIGHBORS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 2, sizeof(cl_mem), &memObjects[MEM_WEIGHTS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 3, sizeof(cl_mem), &memObjects[MEM_EDGE_IDS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 4, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 5, sizeof(cl_mem), &memObjects[MEM_VERTEX_MIN_EDGE]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE], 6, sizeof(cl_mem), &memObjects[MEM_MIN_WEIGHT]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE], 1, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE], 2, sizeof(cl_mem), &memObjects[MEM_VERTEX_MIN_EDGE]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE], 3, sizeof(cl_mem), &memObjects[MEM_MIN_WEIGHT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE], 4, sizeof(cl_mem), &memObjects[MEM_MIN_EDGE]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_WEIGHT_PER_EDGE], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_WEIGHT_PER_EDGE], 1, sizeof(cl_mem), &memObjects[MEM_MIN_WEIGHT]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE_PER_EDGE], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE_PER_EDGE], 1, sizeof(cl_mem), &memObjects[MEM_MIN_WEIGHT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_SELECT_MIN_EDGE_PER_EDGE], 2, sizeof(cl_mem), &memObjects[MEM_MIN_EDGE]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 1, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 2, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 3, sizeof(cl_mem), &memObjects[MEM_MIN_EDGE]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 4, sizeof(cl_mem), &memObjects[MEM_SUCCESSOR]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 5, sizeof(cl_mem), &memObjects[MEM_MST_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_HOOK], 6, sizeof(cl_mem), &memObjects[MEM_MST_COUNT]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_FILTER], 0, sizeof(cl_mem), &memObjects[MEM_OFFSETS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FILTER], 1, sizeof(cl_mem), &memObjects[MEM_NEIGHBORS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_FILTER], 2, sizeof(cl_mem), &memObjects[MEM_SUCCESSOR]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_RELABEL], 0, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_RELABEL], 1, sizeof(cl_mem), &memObjects[MEM_SUCCESSOR]);
+    errNum |= clSetKernelArg(kernels[KERNEL_RELABEL], 2, sizeof(cl_mem), &memObjects[MEM_MIN_WEIGHT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_RELABEL], 3, sizeof(cl_mem), &memObjects[MEM_MIN_EDGE]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_MARK_LIVE], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_MARK_LIVE], 1, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_MARK_LIVE], 2, sizeof(cl_mem), &memObjects[MEM_LIVE_FLAGS]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 1, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 2, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 3, sizeof(cl_mem), &memObjects[MEM_LIVE_FLAGS]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 4, sizeof(cl_mem), &memObjects[MEM_EDGES_OUT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COMPACT], 5, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS_OUT]);
+
+    errNum |= clSetKernelArg(kernels[KERNEL_COUNT], 0, sizeof(cl_mem), &memObjects[MEM_PARENT]);
+    errNum |= clSetKernelArg(kernels[KERNEL_COUNT], 1, sizeof(cl_mem), &memObjects[MEM_COMPONENTS]);
+
+    if (kernels[KERNEL_FIND_MIN_EDGE_KEY] != 0) {
+        errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE_KEY], 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+        errNum |= clSetKernelArg(kernels[KERNEL_FIND_MIN_EDGE_KEY], 1, sizeof(cl_mem), &memObjects[MEM_MIN_KEY]);
+
+        errNum |= clSetKernelArg(kernels[KERNEL_UNPACK_MIN_EDGE], 0, sizeof(cl_mem), &memObjects[MEM_MIN_KEY]);
+        errNum |= clSetKernelArg(kernels[KERNEL_UNPACK_MIN_EDGE], 1, sizeof(cl_mem), &memObjects[MEM_MIN_EDGE]);
+    }
+
     if (errNum != CL_SUCCESS) {
-        cout << "Could not create GPU context, trying CPU..." << endl;
-        context = clCreateContextFromType(contextProperties, CL_DEVICE_TYPE_CPU,
-                                            NULL, NULL, &errNum);
-        if (errNum != CL_SUCCESS) {
-            cerr << "Failed to create an OpenCL GPU or CPU context." << endl;
-            return NULL;
-        }
+        cerr << "Error setting Kernel arguments." << endl;
+        return false;
     }
 
-    return context;
+    return true;
 }
 
-/* Creates a command queue on the device available on the context */
-cl_command_queue CreateCommandQueue(cl_context context, cl_device_id *device) {
+/* Labels every vertex with the root of its tree by pointer jumping until
+*  no label changes
+*
+*  The jumps are queued in batches of doubling size and the changed flag
+*  is only reset before the last jump of a batch, so the host syncs a
+*  handful of times even for deep trees.
+*
+*  labels => parent of every vertex, holds its root on return
+*  jumps => number of jumps it took
+*/
+bool LabelComponents(cl_command_queue commandQueue, cl_kernel jumpKernel, cl_mem labels,
+                     cl_mem changedFlag, int numVertices, int &jumps) {
     cl_int errNum;
-    cl_device_id *devices;
-    cl_command_queue commandQueue = NULL;
-    size_t deviceBufferSize = -1;
+    int changed = 1
+    ,   zero = ZERO
+    ,   batch = 1;
 
-    /* Gets the size of the devices buffer */
-    errNum = clGetContextInfo(context, CL_CONTEXT_DEVICES, ZERO, NULL, &deviceBufferSize);
+    errNum = clSetKernelArg(jumpKernel, 0, sizeof(cl_mem), &labels);
+    errNum |= clSetKernelArg(jumpKernel, 1, sizeof(cl_mem), &changedFlag);
     if (errNum != CL_SUCCESS) {
-        cerr << "Failed call to clGetContextInfo(...,GL_CONTEXT_DEVICES,...)";
-        return NULL;
+        cerr << "Error setting Kernel arguments." << endl;
+        return false;
     }
 
-    if (deviceBufferSize <= ZERO) {
-        cerr << "No devices available.";
-        return NULL;
+    jumps = 0;
+    while (changed) {
+        for (int j = 1; j < batch; j++) {
+            if (!EnqueueKernel(commandQueue, jumpKernel, numVertices, NULL))
+                return false;
+        }
+
+        errNum = clEnqueueWriteBuffer(commandQueue, changedFlag, CL_FALSE,
+                                      0, sizeof(int), &zero, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS
+            || !EnqueueKernel(commandQueue, jumpKernel, numVertices, NULL)) {
+            cerr << "Error queuing pointer jumps." << endl;
+            return false;
+        }
+
+        errNum = clEnqueueReadBuffer(commandQueue, changedFlag, CL_TRUE,
+                                     0, sizeof(int), &changed, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS) {
+            cerr << "Error reading changed flag." << endl;
+            return false;
+        }
+
+        jumps += batch;
+        batch *= 2;
     }
 
-    /* Allocates memory for the devices buffer */
-    devices = new cl_device_id[deviceBufferSize / sizeof(cl_device_id)];
-    errNum = clGetContextInfo(context, CL_CONTEXT_DEVICES, deviceBufferSize, devices, NULL);
-    if (errNum != CL_SUCCESS) {
-        delete [] devices;
-        cerr << "Failed to get device IDs";
-        return NULL;
+    return true;
+}
+
+/* Queues up the minimum edge selection of one round */
+bool EnqueueMinEdge(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+                    Min_Edge_Mode mode, int numVertices, int numEdges, cl_event* event) {
+    switch (mode) {
+    case MIN_EDGE_EDGE:
+        return EnqueueKernel(commandQueue, kernels[KERNEL_FIND_MIN_EDGE_KEY], numEdges, event)
+            && EnqueueKernel(commandQueue, kernels[KERNEL_UNPACK_MIN_EDGE], numVertices, NULL);
+    case MIN_EDGE_EDGE32:
+        return EnqueueKernel(commandQueue, kernels[KERNEL_FIND_MIN_WEIGHT_PER_EDGE], numEdges, event)
+            && EnqueueKernel(commandQueue, kernels[KERNEL_SELECT_MIN_EDGE_PER_EDGE], numEdges, NULL);
+    default:
+        return EnqueueKernel(commandQueue, kernels[KERNEL_FIND_MIN_EDGE], numVertices, event)
+            && EnqueueKernel(commandQueue, kernels[KERNEL_SELECT_MIN_EDGE], numVertices, NULL);
     }
+}
 
-    /* Sets command queue properties */
-    cl_command_queue_properties cmdQProperties = {
-        CL_QUEUE_PROFILING_ENABLE
-    };
+/* Makes the output edge buffers the live ones */
+void SwapEdgeBuffers(cl_mem memObjects[NUM_MEM_OBJECTS]) {
+    cl_mem temp = memObjects[MEM_EDGES];
+    memObjects[MEM_EDGES] = memObjects[MEM_EDGES_OUT];
+    memObjects[MEM_EDGES_OUT] = temp;
 
-    /* Chooses the first available device */
-    commandQueue = clCreateCommandQueue(context, devices[0], cmdQProperties, NULL);
-    if (commandQueue == NULL) {
-        delete [] devices;
-        cerr << "Failed to create commandQueue for device 0";
-        return NULL;
+    temp = memObjects[MEM_ORIGINAL_IDS];
+    memObjects[MEM_ORIGINAL_IDS] = memObjects[MEM_ORIGINAL_IDS_OUT];
+    memObjects[MEM_ORIGINAL_IDS_OUT] = temp;
+}
+
+/* Drops the edges that became self-loops of a component: flags the live
+*  edges, scans the flags into positions and moves the live edges there,
+*  then swaps the compacted buffers in
+*
+*  numEdges => number of live edges, updated on return
+*/
+bool CompactEdges(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+                  cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan, int &numEdges) {
+    cl_int live = ZERO;
+
+    bool queued = EnqueueKernel(commandQueue, kernels[KERNEL_MARK_LIVE], numEdges, NULL)
+               && ScanDevice(commandQueue, scan, SCAN_INT, memObjects[MEM_LIVE_FLAGS], numEdges, &live)
+               && EnqueueKernel(commandQueue, kernels[KERNEL_COMPACT], numEdges, NULL);
+    if (!queued) {
+        cerr << "Error compacting edges." << endl;
+        return false;
     }
 
-    *device = devices[0];
-    delete [] devices;
-    return commandQueue;
+    SwapEdgeBuffers(memObjects);
+    numEdges = live;
+    return true;
 }
 
-/* Create an OpenCL program from the Kernel source file */
-cl_program CreateProgram(cl_context context, cl_device_id device, const char* fileName) {
+/* Radix sorts the live edges by (v1, v2, weight), one pass per digit
+*  that can differ - the digit counts of every pass are scanned on the
+*  device, so nothing is read back
+*
+*  minWeight, maxWeight => range of the edge weights
+*/
+bool SortEdges(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+               cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan, int numEdges,
+               int numVertices, int minWeight, int maxWeight) {
     cl_int errNum;
-    cl_program program;
+    cl_kernel countKernel = kernels[KERNEL_RADIX_COUNT]
+    ,         scatterKernel = kernels[KERNEL_RADIX_SCATTER];
+    int threads = (numEdges + SORT_ITEMS_PER_THREAD - 1) / SORT_ITEMS_PER_THREAD
+    ,   items = SORT_ITEMS_PER_THREAD
+    ,   digits[NUM_SORT_FIELDS];
+
+    digits[SORT_WEIGHT] = significantDigits((uint32_t) minWeight ^ 0x80000000u,
+                                            (uint32_t) maxWeight ^ 0x80000000u, SORT_RADIX_BITS);
+    digits[SORT_V2] = digits[SORT_V1] = significantDigits(0, numVertices - 1, SORT_RADIX_BITS);
+
+    for (int field = 0; field < NUM_SORT_FIELDS; field++) {
+        for (int d = 0; d < digits[field]; d++) {
+            int shift = d * SORT_RADIX_BITS;
+
+            errNum = clSetKernelArg(countKernel, 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+            errNum |= clSetKernelArg(countKernel, 1, sizeof(int), &numEdges);
+            errNum |= clSetKernelArg(countKernel, 2, sizeof(int), &field);
+            errNum |= clSetKernelArg(countKernel, 3, sizeof(int), &shift);
+            errNum |= clSetKernelArg(countKernel, 4, sizeof(int), &items);
+            errNum |= clSetKernelArg(countKernel, 5, sizeof(cl_mem), &memObjects[MEM_SORT_COUNTS]);
+
+            errNum |= clSetKernelArg(scatterKernel, 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+            errNum |= clSetKernelArg(scatterKernel, 1, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS]);
+            errNum |= clSetKernelArg(scatterKernel, 2, sizeof(int), &numEdges);
+            errNum |= clSetKernelArg(scatterKernel, 3, sizeof(int), &field);
+            errNum |= clSetKernelArg(scatterKernel, 4, sizeof(int), &shift);
+            errNum |= clSetKernelArg(scatterKernel, 5, sizeof(int), &items);
+            errNum |= clSetKernelArg(scatterKernel, 6, sizeof(cl_mem), &memObjects[MEM_SORT_COUNTS]);
+            errNum |= clSetKernelArg(scatterKernel, 7, sizeof(cl_mem), &memObjects[MEM_EDGES_OUT]);
+            errNum |= clSetKernelArg(scatterKernel, 8, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS_OUT]);
+            if (errNum != CL_SUCCESS) {
+                cerr << "Error setting Kernel arguments." << endl;
+                return false;
+            }
+
+            bool queued = EnqueueKernel(commandQueue, countKernel, threads, NULL)
+                       && ScanDevice(commandQueue, scan, SCAN_INT, memObjects[MEM_SORT_COUNTS],
+                                     SORT_RADIX_BUCKETS * threads, NULL)
+                       && EnqueueKernel(commandQueue, scatterKernel, threads, NULL);
+            if (!queued) {
+                cerr << "Error sorting edges." << endl;
+                return false;
+            }
 
-    ifstream kernelFile(fileName, ios::in);
-    if (!kernelFile.is_open()) {
-        cerr << "Failed to open file for reading: " << fileName << endl;
-        return NULL;
+            SwapEdgeBuffers(memObjects);
+        }
     }
 
-    ostringstream oss;
-    oss << kernelFile.rdbuf();
+    return true;
+}
 
-    string srcStdStr = oss.str();
-    const char *srcStr = srcStdStr.c_str();
+/* Keeps the lightest of every run of parallel edges once they're sorted
+*
+*  numEdges => number of live edges, updated on return
+*/
+bool UniqueEdges(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+                 cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan, int &numEdges) {
+    cl_int errNum
+    ,      unique = ZERO;
+    cl_kernel markKernel = kernels[KERNEL_MARK_HEADS]
+    ,         gatherKernel = kernels[KERNEL_GATHER_HEADS];
+
+    errNum = clSetKernelArg(markKernel, 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(markKernel, 1, sizeof(cl_mem), &memObjects[MEM_LIVE_FLAGS]);
+
+    errNum |= clSetKernelArg(gatherKernel, 0, sizeof(cl_mem), &memObjects[MEM_EDGES]);
+    errNum |= clSetKernelArg(gatherKernel, 1, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS]);
+    errNum |= clSetKernelArg(gatherKernel, 2, sizeof(cl_mem), &memObjects[MEM_LIVE_FLAGS]);
+    errNum |= clSetKernelArg(gatherKernel, 3, sizeof(cl_mem), &memObjects[MEM_EDGES_OUT]);
+    errNum |= clSetKernelArg(gatherKernel, 4, sizeof(cl_mem), &memObjects[MEM_ORIGINAL_IDS_OUT]);
+    if (errNum != CL_SUCCESS) {
+        cerr << "Error setting Kernel arguments." << endl;
+        return false;
+    }
 
-    program = clCreateProgramWithSource(context, 1, (const char**)&srcStr, NULL, NULL);
-    if (program == NULL) {
-        cerr << "Failed to create CL program from source." << endl;
-        return NULL;
+    bool queued = EnqueueKernel(commandQueue, markKernel, numEdges, NULL)
+               && ScanDevice(commandQueue, scan, SCAN_INT, memObjects[MEM_LIVE_FLAGS], numEdges, &unique)
+               && EnqueueKernel(commandQueue, gatherKernel, numEdges, NULL);
+    if (!queued) {
+        cerr << "Error removing parallel edges." << endl;
+        return false;
     }
 
-    errNum = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
-    if (errNum != CL_SUCCESS) {
-        /* Gets program's errors */
-        char buildLog[16384];
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG,
-                                sizeof(buildLog), buildLog, NULL);
+    SwapEdgeBuffers(memObjects);
+    numEdges = unique;
+    return true;
+}
 
-        cerr << "Error in Kernel: " << endl;
-        cerr << buildLog;
-        clReleaseProgram(program);
-        return NULL;
+/* Contracts the live edge list after a round: drops the self-loops, then
+*  the parallel edges, and binds the Kernels to the new edge buffers
+*/
+bool ContractEdges(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+                   cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan, int &numEdges,
+                   int numVertices, int minWeight, int maxWeight) {
+    return CompactEdges(commandQueue, kernels, memObjects, scan, numEdges)
+        && SortEdges(commandQueue, kernels, memObjects, scan, numEdges,
+                     numVertices, minWeight, maxWeight)
+        && UniqueEdges(commandQueue, kernels, memObjects, scan, numEdges)
+        && SetKernelArgs(kernels, memObjects);
+}
+
+/* Reads the edges still crossing two components back to the Host, the
+*  endpoints turned into component labels. The edge-parallel modes keep
+*  them compacted on the device already; the vertex-parallel one reads
+*  the labels and compacts the original edge list on the Host.
+*
+*  E, ids => receive the live edges and their original indices, hold
+*            numEdges entries
+*  numLive => number of live edges
+*/
+bool ReadLiveEdges(cl_command_queue commandQueue, cl_mem memObjects[NUM_MEM_OBJECTS],
+                   Min_Edge_Mode mode, int numVertices, int numEdges,
+                   Edge* E, int* ids, int &numLive) {
+    cl_int errNum;
+
+    if (mode != MIN_EDGE_VERTEX) {
+        errNum = clEnqueueReadBuffer(commandQueue, memObjects[MEM_EDGES], CL_TRUE,
+                                     0, sizeof(Edge) * numEdges, E, 0, NULL, NULL);
+        errNum |= clEnqueueReadBuffer(commandQueue, memObjects[MEM_ORIGINAL_IDS], CL_TRUE,
+                                      0, sizeof(int) * numEdges, ids, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS) {
+            cerr << "Error reading live edges." << endl;
+            return false;
+        }
+
+        numLive = numEdges;
+        return true;
+    }
+
+    Edge* EI = new Edge[numEdges];
+    int* parent = new int[numVertices];
+    int* identity = new int[numEdges];
+
+    errNum = clEnqueueReadBuffer(commandQueue, memObjects[MEM_EDGES], CL_TRUE,
+                                 0, sizeof(Edge) * numEdges, EI, 0, NULL, NULL);
+    errNum |= clEnqueueReadBuffer(commandQueue, memObjects[MEM_PARENT], CL_TRUE,
+                                  0, sizeof(int) * numVertices, parent, 0, NULL, NULL);
+    if (errNum == CL_SUCCESS) {
+        for(int i = 0; i < numEdges; i++)
+            identity[i] = i;
+
+        numLive = compactEdges(EI, identity, numEdges, parent, E, ids, hostPool().numThreads);
+    } else {
+        cerr << "Error reading component labels." << endl;
     }
 
-    return program;
+    delete [] EI;
+    delete [] parent;
+    delete [] identity;
+
+    return errNum == CL_SUCCESS;
 }
 
-/* Create memory objects to be used as arguments to the Kernel */
-bool CreateMemObjects(cl_context context, cl_mem memObjects[3], Edge* EI) {
-    memObjects[0] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                    sizeof(Edge) * NUM_EDGES, EI, NULL);
-    memObjects[1] = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(Edge) * NUM_EDGES, NULL, NULL);
-    memObjects[2] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                    sizeof(int) * 1, &NUM_EDGES, NULL);
-
-    if (memObjects[0] == NULL || memObjects[1] == NULL || memObjects[2] == NULL) {
-        cerr << "Error creating memory objects." << endl;
-        return false;
+/* Runs Boruvka's rounds on the device until a single component is left
+*  (or no edges cross the components). Besides the pointer jumping flag
+*  and the live edges count, only the number of components remaining is
+*  read back per round.
+*
+*  mode => how the minimum edges are found, the edge-parallel modes
+*          contract the edge list every round while the vertex-parallel
+*          one marks the dead CSR entries instead
+*  minWeight, maxWeight => range of the edge weights
+*  finish => when to stop the rounds for the Host finish, raises finished
+*  liveEdges, liveIds => receive the live edges once finished, hold
+*                        numEdges entries
+*  numLive => number of live edges read back
+*  rounds => number of Boruvka rounds it took
+*  start => event of the first Kernel, used for profiling
+*  returns the number of MST edges found on the device, -1 on error
+*/
+int RunBoruvka(cl_command_queue commandQueue, cl_kernel kernels[NUM_KERNELS],
+               cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan, Min_Edge_Mode mode,
+               int numVertices, int numEdges, int minWeight, int maxWeight,
+               Hybrid_Finish &finish, Edge* liveEdges, int* liveIds, int &numLive,
+               int &rounds, cl_event* start) {
+    cl_int errNum;
+    int components = numVertices
+    ,   remaining = ZERO
+    ,   mstCount = ZERO
+    ,   zero = ZERO
+    ,   jumps = ZERO;
+
+    rounds = 0;
+    while (components > 1) {
+        bool queued = EnqueueMinEdge(commandQueue, kernels, mode, numVertices, numEdges,
+                                     rounds == 0 ? start : NULL)
+                   && EnqueueKernel(commandQueue, kernels[KERNEL_HOOK], numVertices, NULL)
+                   && LabelComponents(commandQueue, kernels[KERNEL_JUMP], memObjects[MEM_SUCCESSOR],
+                                      memObjects[MEM_CHANGED], numVertices, jumps);
+        if (queued && mode == MIN_EDGE_VERTEX)
+            queued = EnqueueKernel(commandQueue, kernels[KERNEL_FILTER], numVertices, NULL);
+        if (queued)
+            queued = EnqueueKernel(commandQueue, kernels[KERNEL_RELABEL], numVertices, NULL);
+        if (queued && mode != MIN_EDGE_VERTEX)
+            queued = ContractEdges(commandQueue, kernels, memObjects, scan, numEdges,
+                                   numVertices, minWeight, maxWeight);
+        if (!queued) return -1;
+
+        /* Counts the components left on the device */
+        errNum = clEnqueueWriteBuffer(commandQueue, memObjects[MEM_COMPONENTS], CL_FALSE,
+                                      0, sizeof(int), &zero, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS
+            || !EnqueueKernel(commandQueue, kernels[KERNEL_COUNT], numVertices, NULL)) {
+            cerr << "Error counting components." << endl;
+            return -1;
+        }
+
+        errNum = clEnqueueReadBuffer(commandQueue, memObjects[MEM_COMPONENTS], CL_TRUE,
+                                     0, sizeof(int), &remaining, 0, NULL, NULL);
+        if (errNum != CL_SUCCESS) {
+            cerr << "Error reading components count." << endl;
+            return -1;
+        }
+
+        /* No edges left between the components */
+        if (remaining == components) break;
+
+        components = remaining;
+        rounds++;
+
+        /* Few components or live edges left, the Host finishes the MST */
+        if (shouldFinish(finish, components, numEdges)) {
+            if (!ReadLiveEdges(commandQueue, memObjects, mode, numVertices, numEdges,
+                               liveEdges, liveIds, numLive))
+                return -1;
+
+            finish.finished = true;
+            break;
+        }
     }
 
-    return true;
+    errNum = clEnqueueReadBuffer(commandQueue, memObjects[MEM_MST_COUNT], CL_TRUE,
+                                 0, sizeof(int), &mstCount, 0, NULL, NULL);
+    if (errNum != CL_SUCCESS) {
+        cerr << "Error reading MST edges count." << endl;
+        return -1;
+    }
+
+    return mstCount;
 }
 
 /* Cleans up all (created) OpenCL resources */
 void Cleanup(cl_context context, cl_command_queue commandQueue,
-             cl_program program, cl_kernel kernel, cl_mem memObjects[3]) {
-    for (int i = 0; i < 3; i++) {
+             cl_program program, cl_kernel kernels[NUM_KERNELS],
+             cl_mem memObjects[NUM_MEM_OBJECTS], Device_Scan &scan) {
+    ReleaseDeviceScan(scan);
+
+    for (int i = 0; i < NUM_MEM_OBJECTS; i++) {
         if (memObjects[i] != 0)
             clReleaseMemObject(memObjects[i]);
     }
     if (commandQueue != 0)
         clReleaseCommandQueue(commandQueue);
 
-    if (kernel != 0)
-        clReleaseKernel(kernel);
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        if (kernels[i] != 0)
+            clReleaseKernel(kernels[i]);
+    }
 
     if (program != 0)
         clReleaseProgram(program);
@@ -313,170 +781,521 @@ void Cleanup(cl_context context, cl_command_queue commandQueue,
         clReleaseContext(context);
 }
 
-/* Main function */
-int main(int argc, char** argv) {
-    /* Some variables' declarations and initializations */
-    cl_context context = 0;
+/* Engines that can find the MST */
+enum Engine {
+    ENGINE_OPENCL,      /* every round on the OpenCL device */
+    ENGINE_CPU,         /* every round on native host threads */
+    ENGINE_DENSE,       /* straight on the adjacency matrix */
+    ENGINE_COMPRESSED,  /* host threads over the compressed adjacency */
+    ENGINE_EXTERNAL,    /* semi-external, the edges streamed from disk */
+    ENGINE_AUTO,        /* dense engine for dense graphs, OpenCL otherwise */
+    NUM_ENGINES
+};
+
+const char* engineNames[NUM_ENGINES] = { "opencl", "cpu", "dense", "compressed", "external", "auto" };
+
+/* Looks up an engine by name, false if it's unknown */
+bool ParseEngine(const char* name, Engine &engine) {
+    for (int i = 0; i < NUM_ENGINES; i++) {
+        if (strcmp(name, engineNames[i]) == 0) {
+            engine = (Engine) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Parses the command line
+*
+*  --vertex-parallel => one work-item per vertex finds the minimum edges,
+*                       the default is one work-item per edge
+*  --engine opencl|cpu|dense|compressed|external|auto => which engine
+*                                    finds the MST, the default (auto)
+*                                    picks the dense one above the density
+*                                    threshold, else OpenCL with the CPU
+*                                    one as fallback
+*  --dense prim|boruvka => algorithm of the dense engine, the default is Prim
+*  --dense-threshold X => edge density E / V^2 picking the dense engine
+*  --threads N => host threads of the pool (CPU engine and host phases)
+*  --pin => pins every pool thread to its own core
+*  --huge-pages => backs the adjacency matrix with huge pages
+*  --graph, --vertices, ... => the random graph, see parseGeneratorOption
+*  --isa scalar|avx2|avx512 => instruction set of the host hot loops, the
+*                              default is the widest the CPU supports
+*  --finish kruskal|prim|none => how the MST of the small contracted graph
+*                                is finished, the default is Kruskal
+*  --finish-components N, --finish-edges N => thresholds of the finish
+*  --output FILE, --output-format F => where and how the MST is written,
+*                                      see parseOutputOption
+*  --spill-dir DIR => directory of the spill files of the external engine
+*  --memory-edges N => live edges the external engine finishes in memory
+*/
+bool parseArguments(int argc, char** argv, Min_Edge_Mode &mode, Engine &engine,
+                    Dense_Algorithm &dense, double &denseThreshold,
+                    int &numThreads, bool &pin, bool &hugePages, Hybrid_Finish &finish,
+                    Generator_Options &generator, Output_Options &output,
+                    External_Options &external) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vertex-parallel") == 0) {
+            mode = MIN_EDGE_VERTEX;
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc
+                   && ParseEngine(argv[i + 1], engine)) {
+            i++;
+        } else if (strcmp(argv[i], "--dense") == 0 && i + 1 < argc
+                   && parseDenseAlgorithm(argv[i + 1], dense)) {
+            i++;
+        } else if (strcmp(argv[i], "--dense-threshold") == 0 && i + 1 < argc
+                   && atof(argv[i + 1]) >= 0) {
+            denseThreshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else if (strcmp(argv[i], "--huge-pages") == 0) {
+            hugePages = true;
+        } else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc) {
+            if (!selectIsa(argv[++i])) {
+                cerr << "Instruction set " << argv[i] << " is unknown or not supported." << endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--finish") == 0 && i + 1 < argc
+                   && parseFinishAlgorithm(argv[i + 1], finish.algorithm)) {
+            i++;
+        } else if (strcmp(argv[i], "--finish-components") == 0 && i + 1 < argc
+                   && atoi(argv[i + 1]) >= 0) {
+            finish.maxComponents = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--finish-edges") == 0 && i + 1 < argc
+                   && atoi(argv[i + 1]) >= 0) {
+            finish.maxEdges = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spill-dir") == 0 && i + 1 < argc) {
+            external.spillDir = argv[++i];
+        } else if (strcmp(argv[i], "--memory-edges") == 0 && i + 1 < argc
+                   && atoi(argv[i + 1]) >= 0) {
+            external.memoryEdges = atoi(argv[++i]);
+        } else if (parseGeneratorOption(argc, argv, i, generator)
+                   || parseOutputOption(argc, argv, i, output)) {
+            continue;
+        } else {
+            cerr << "Unknown argument: " << argv[i] << endl;
+            cerr << "Usage: " << argv[0]
+                 << " [--vertex-parallel] [--engine opencl|cpu|dense|compressed|external|auto]"
+                 << " [--dense prim|boruvka] [--dense-threshold X] [--threads N] [--pin]"
+                 << " [--huge-pages] [--graph matrix|gnp|gnm|rmat|grid2d|grid3d|geometric|knn]"
+                 << " [--vertices N] [--edges M] [--probability P] [--scale S] [--edge-factor F]"
+                 << " [--rmat A,B,C,D] [--radius R] [--neighbors K]"
+                 << " [--weights uniform|constant|exponential]"
+                 << " [--max-weight W] [--seed S] [--connected] [--input FILE [--verify]]"
+                 << " [--isa scalar|avx2|avx512] [--finish kruskal|prim|none]"
+                 << " [--finish-components N] [--finish-edges N] [--output FILE|-]"
+                 << " [--output-format text|binary|delta|none] [--spill-dir DIR]"
+                 << " [--memory-edges N]" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Runs every Boruvka round on the OpenCL device of the context, which it
+*  takes over and releases
+*
+*  mode => how the minimum edges are found, downgraded without 64-bit atomics
+*  finish => when and how the Host finishes the MST, raises finished
+*  csr => CSR form of ES at hand (a mapped graph file), NULL to build it
+*  numThreads => host threads building the CSR form
+*  mstEdges => indices into ES of the MST edges
+*  ms => device time of the rounds plus Host time of the finish
+*  returns the number of MST edges, -1 on error
+*/
+int RunDeviceEngine(cl_context context, Edge* ES, const CSR_Graph* csr, int numThreads,
+                    Min_Edge_Mode &mode, Hybrid_Finish &finish, int* mstEdges, int &rounds,
+                    double &ms) {
     cl_command_queue commandQueue = 0;
     cl_program program = 0;
     cl_device_id device = 0;
-    cl_kernel kernel = 0;
-    cl_mem memObjects[3] = { 0, 0, 0 };
-    cl_int errNum;                                                                                                                                                                                                                                                                              
-
-    /* Creates an OpenCL context on first available platform */
-    context = CreateContext();
-    if (context == NULL) {
-        cerr << "Failed to create OpenCL context." << endl;
-        return 1;
-    }
+    cl_kernel kernels[NUM_KERNELS] = { 0 };
+    cl_mem memObjects[NUM_MEM_OBJECTS] = { 0 };
+    Device_Scan scan = Device_Scan();
+    cl_int errNum;
 
     /* Creates a command queue on the device available on the context */
     commandQueue = CreateCommandQueue(context, &device);
     if (commandQueue == NULL) {
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    // Create OpenCL program from 0.cl kernel source
-    program = CreateProgram(context, device, "_kernel.cl");                                                                                                              
+    /* Create OpenCL program from _kernel.cl kernel source */
+    program = CreateProgram(context, device, "_kernel.cl");
     if (program == NULL) {
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    /* Create OpenCL Kernel */
-    kernel = clCreateKernel(program, "findMinEdge", NULL);
-    if (kernel == NULL) {
-        cerr << "Failed to create Kernel" << endl;
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+    /* Falls back to 32-bit atomics without cl_khr_int64_extended_atomics */
+    bool int64Atomics = HasExtension(device, "cl_khr_int64_extended_atomics");
+    if (mode == MIN_EDGE_EDGE && !int64Atomics)
+        mode = MIN_EDGE_EDGE32;
+
+    /* Create OpenCL Kernels */
+    if (!CreateKernels(program, kernels, int64Atomics)) {
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    /* Generates a random Graph */
-    int** adjMatrix = generateRandomGraph(NUM_EDGES);
-    int c = 0;
-    NUM_EDGES--;
+    /* Builds the CSR form of the graph once, unless the graph file has it */
+    bool ownCSR = csr == NULL;
+    CSR_Graph graph = ownCSR ? buildCSR(ES, NUM_EDGES, NUM_VERTICES, numThreads) : *csr;
 
-    Edge* ES = new Edge[NUM_EDGES];
-    Edge* E = new Edge[NUM_EDGES];
+    /* Weight range bounds the radix sort passes */
+    int minWeight = 0
+    ,   maxWeight = 0;
 
-    /* Extracts edges' info from Adjacency Matrix */
-    for(int i = 0; i < NUM_VERTICES; i++) {
-        for(int j = 0; j < NUM_VERTICES; j++) {
-            if(i == j) continue;
-            if(adjMatrix[i][j] > 0 && c < NUM_EDGES) {
-                ES[c].v1 = i;
-                ES[c].v2 = j;
-                ES[c].w = adjMatrix[i][j];
-                c++;
-            }
-        }
+    isa().weightRange(ES, NUM_EDGES, &minWeight, &maxWeight);
+
+    /* The scan covers both the edge flags and the sort digit counts */
+    int maxScan = SortCountsSize(NUM_EDGES) > NUM_EDGES ? SortCountsSize(NUM_EDGES) : NUM_EDGES;
+
+    bool created = CreateMemObjects(context, memObjects, ES, graph)
+                && SetKernelArgs(kernels, memObjects)
+                && CreateDeviceScan(context, program, device, maxScan, scan);
+    if (ownCSR)
+        freeCSR(graph);
+    if (!created) {
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    if (NUM_VERTICES <= 30)
-        displayAdjacencyMatrix(adjMatrix);
-    //displayEdgeList(ES, NUM_EDGES);
+    /* Ensures to have executed all enqueued tasks */
+    clFinish(commandQueue);
 
-    if (!CreateMemObjects(context, memObjects, ES)) {
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+    /* Runs the Boruvka rounds on the device */
+    cl_event start, end;
+    Edge* liveEdges = new Edge[NUM_EDGES];
+    int* liveIds = new int[NUM_EDGES];
+    int numLive = 0;
+
+    int t = RunBoruvka(commandQueue, kernels, memObjects, scan, mode,
+                       NUM_VERTICES, NUM_EDGES, minWeight, maxWeight,
+                       finish, liveEdges, liveIds, numLive, rounds, &start);
+    if (t < 0) {
+        delete [] liveEdges;
+        delete [] liveIds;
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    /* Set the Kernel arguments */
-    errNum = clSetKernelArg(kernel, 0, sizeof(cl_mem), &memObjects[0]);
-    errNum |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &memObjects[1]);
-    errNum |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &memObjects[2]);
+    /* Reads the MST edges back to the Host */
+    errNum = clEnqueueReadBuffer(commandQueue, memObjects[MEM_MST_EDGES], CL_TRUE,
+                                 0, NUM_VERTICES * sizeof(int), mstEdges,
+                                 0, NULL, &end);
     if (errNum != CL_SUCCESS) {
-        cerr << "Error setting Kernel arguments." << endl;
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+        cerr << "Error reading result buffer." << endl;
+        delete [] liveEdges;
+        delete [] liveIds;
+        Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+        return -1;
     }
 
-    /* Ensures to have executed all enqueued tasks */
-    clFinish(commandQueue);
+    /* Finishes the MST of the contracted graph on the Host */
+    double finishMs = 0;
 
-    size_t globalWorkSize[1] = { NUM_VERTICES };
-    size_t localWorkSize[1] = { 1 };
-    cl_event event;
+    if (finish.finished) {
+        chrono::steady_clock::time_point finishStart = chrono::steady_clock::now();
+        t += finishMST(finish, liveEdges, liveIds, numLive, NUM_VERTICES, mstEdges + t);
+        finishMs = chrono::duration<double, milli>(chrono::steady_clock::now() - finishStart).count();
+    }
 
-    /* Queues the Kernel up for execution across the array */
-    errNum = clEnqueueNDRangeKernel(commandQueue, kernel, 1, NULL,
-                                    globalWorkSize, localWorkSize,
-                                    0, NULL, &event);
+    delete [] liveEdges;
+    delete [] liveIds;
 
-    /* Ensures Kernel execution is finished */
-    clWaitForEvents(1 , &event);
+                                            /* Gets the profiling data */
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        cl_ulong time_start, time_end;
 
-    if (errNum != CL_SUCCESS) {
-        cerr << "Error queuing Kernel for execution." << endl;
-        Cleanup(context, commandQueue, program, kernel, memObjects);
-        return 1;
+        clGetEventProfilingInfo(start, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
+        clGetEventProfilingInfo(end, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
+        ms = (time_end - time_start) / 1000000.0 + finishMs;
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    clReleaseEvent(start);
+    clReleaseEvent(end);
+
+    /* Releases the allocated resources */
+    Cleanup(context, commandQueue, program, kernels, memObjects, scan);
+
+    return t;
+}
+
+/* Runs the semi-external engine: a mapped graph file is streamed from
+*  its edges section, any other graph is first written to a spill file
+*
+*  path => the --input file, NULL for a generated graph
+*  numThreads => threads of the in-memory rounds
+*  mstEdges => indices into ES of the MST edges
+*  ms => time of the rounds, the I/O included
+*  returns the number of MST edges, -1 on error
+*/
+int RunExternalEngine(Edge* ES, const Input_Graph &input, const char* path,
+                      const External_Options &options, int numThreads, int* mstEdges,
+                      int &rounds, Hybrid_Finish &finish, External_Stats &stats, double &ms) {
+    char spill[1024];
+    uint64_t offset = 0;
+
+    if (input.mapped.base != NULL) {
+        offset = (const char*) input.mapped.edges - (const char*) input.mapped.base;
+    } else {
+        snprintf(spill, sizeof(spill), "%s/boruvka-input-%d.bin", options.spillDir, (int) getpid());
+        path = spill;
+
+        FILE* file = fopen(path, "wb");
+        bool written = file != NULL
+                    && fwrite(ES, sizeof(Edge), NUM_EDGES, file) == (size_t) NUM_EDGES;
+
+        if (file != NULL)
+            written = fclose(file) == 0 && written;
+        if (!written) {
+            cerr << "Error writing the edges to " << path << endl;
+            return -1;
+        }
     }
 
-    /* Reads the output buffer back to the Host */
-    errNum = clEnqueueReadBuffer(commandQueue, memObjects[1], CL_TRUE,
-                                 0, NUM_EDGES * sizeof(Edge), E,
-                                 0, NULL, NULL);
-    if (errNum != CL_SUCCESS) {
-        cerr << "Error reading result buffer." << endl;
-        Cleanup(context, commandQueue, program, kernel, memObjects);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int t = externalBoruvkaMST(path, offset, NUM_EDGES, NUM_VERTICES, options, mstEdges,
+                               rounds, finish, stats, numThreads);
+    ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (input.mapped.base == NULL)
+        remove(path);
+    if (t < 0)
+        cerr << "Error streaming the edges of " << path << " or its spill files in "
+             << options.spillDir << endl;
+
+    return t;
+}
+
+/* Main function */
+int main(int argc, char** argv) {
+    /* Some variables' declarations and initializations */
+    Min_Edge_Mode mode = MIN_EDGE_EDGE;
+    Engine engine = ENGINE_AUTO;
+    Dense_Algorithm dense = DENSE_PRIM;
+    double denseThreshold = DENSE_ENGINE_DENSITY;
+    int numThreads = hardwareThreads();
+    bool pin = false
+    ,    hugePages = false;
+    Hybrid_Finish finish = defaultHybridFinish();
+    Generator_Options generator = defaultGeneratorOptions(DEFAULT_VERTICES, MAX_WEIGHT,
+                                                          (uint64_t) time(NULL));
+    Output_Options output = defaultOutputOptions();
+    External_Options external = defaultExternalOptions();
+
+    if (!parseArguments(argc, argv, mode, engine, dense, denseThreshold, numThreads, pin,
+                        hugePages, finish, generator, output, external))
+        return 1;
+    if (output.format == OUTPUT_BINARY && outputToStdout(output)) {
+        cerr << "Error: " << outputStatusNames[OUTPUT_BINARY_STDOUT] << endl;
         return 1;
     }
 
-    /* Displays all min edges */
-    //displayEdgeList(E, NUM_VERTICES);
+    NUM_VERTICES = generator.numVertices;
 
-    /* Creates the forest */
-    Forest_Node** forest = new Forest_Node*[NUM_VERTICES];
+    /* Every host phase runs on the work-stealing pool */
+    configureHostPool(numThreads, pin);
 
-    for(int i = 0; i < NUM_VERTICES; i++)
-        forest[i] = MakeSet(i);
+    /* Reads the input graph, or generates a random Graph - the adjacency
+    *  matrix, or straight the edge list without a matrix behind it
+    */
+    Dense_Matrix adjMatrix = Dense_Matrix();
+    Input_Graph input = Input_Graph();
+    Edge* ES = NULL;
 
-    int e = 0
-    ,   t = 0;
-
-    Edge* mst = new Edge[NUM_EDGES];
-    NUM_EDGES_MST = NUM_VERTICES;
+    if (generator.input != NULL) {
+        if (!loadInputGraph(generator, numThreads, input)) {
+            cerr << "Error reading " << input.description << endl;
+            return 1;
+        }
 
-    while(e < NUM_EDGES_MST) {
-        int v1 = E[e].v1;
-        int v2 = E[e].v2;
+        ES = input.edges;
+        NUM_VERTICES = input.numVertices;
+        NUM_EDGES = input.numEdges;
+    } else if (generator.model == GRAPH_MATRIX) {
+        adjMatrix = generateRandomGraph(NUM_EDGES, generator, numThreads, hugePages);
+        if (adjMatrix.data == NULL) {
+            cerr << "Error allocating the adjacency matrix." << endl;
+            return 1;
+        }
 
-        if(Find(forest[v1]) != Find(forest[v2])) {
-            mst[t] = E[e];
-            Union(forest[v1], forest[v2]);
-            t += 1;
+        if (NUM_VERTICES <= 30)
+            displayAdjacencyMatrix(adjMatrix);
+    } else {
+        ES = generateEdgeList(generator, NUM_EDGES, numThreads);
+        if (ES == NULL) {
+            cerr << "Error generating the graph, more than " << INT_MAX << " edges?" << endl;
+            return 1;
         }
-        e++;
     }
 
-    /* MST Cost */
-    int cost = 0;
+    /* Dense graphs go to the dense engine, the others to OpenCL */
+    if (engine == ENGINE_AUTO)
+        engine = adjMatrix.data != NULL && preferDenseEngine(NUM_EDGES, NUM_VERTICES, denseThreshold)
+               ? ENGINE_DENSE : ENGINE_OPENCL;
+    if (engine == ENGINE_DENSE && (adjMatrix.data == NULL || NUM_VERTICES > DENSE_MAX_VERTICES)) {
+        cerr << "The dense engine needs the adjacency matrix of at most " << DENSE_MAX_VERTICES
+             << " vertices, falling back to the CPU engine." << endl;
+        engine = ENGINE_CPU;
+    }
 
-    cout << endl << "MST [" << endl << "\t";
-    for(int i = 0; i < t; i++){
-        if(i % 10 == 0 && i != 0) cout << endl << "\t";
+    /* Creates an OpenCL context on first available platform */
+    cl_context context = 0;
+    if (engine == ENGINE_OPENCL) {
+        context = CreateContext();
+        if (context == NULL) {
+            cerr << "No OpenCL platform, falling back to the CPU engine." << endl;
+            engine = ENGINE_CPU;
+        }
+    }
+
+    /* Extracts edges' info from Adjacency Matrix - not for the dense engine */
+    if (ES == NULL && engine != ENGINE_DENSE)
+        ES = extractEdges(adjMatrix, NUM_EDGES, numThreads);
+    //displayEdgeList(ES, NUM_EDGES);
 
-        cout << "{" << mst[i].v1 << ", " << mst[i].v2 << "}, ";
-        cost += mst[i].w;
+    /* Compresses the adjacency and drops the edge list - a mapped one
+    *  stays, it's in the page cache rather than in memory of its own
+    */
+    Compressed_Graph compressed = Compressed_Graph();
+    double compressMs = 0;
+
+    if (engine == ENGINE_COMPRESSED) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        compressed = compressGraph(ES, NUM_EDGES, NUM_VERTICES, numThreads);
+        compressMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        if (input.mapped.base == NULL) {
+            if (input.edges != NULL)
+                freeInputGraph(input);
+            else
+                delete [] ES;
+            ES = NULL;
+        }
     }
-    cout << endl << "]" << endl;
-    cout << endl << "MST Cost :: " << cost;
 
-                                            /* Gets the profiling data */
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-        cl_ulong time_start, time_end;
-        double total_time;
+    /* Runs the chosen engine */
+    int* mstEdges = new int[NUM_VERTICES];
+    Edge* mst = new Edge[NUM_VERTICES];
+    int rounds = 0;
+    double ms = 0;
+    External_Stats externalStats = External_Stats();
+
+    if (engine == ENGINE_DENSE) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (dense == DENSE_PRIM)
+            NUM_EDGES_MST = densePrimMST(adjMatrix, mst);
+        else
+            NUM_EDGES_MST = denseBoruvkaMST(adjMatrix, mst, rounds, numThreads);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } else if (engine == ENGINE_CPU) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        NUM_EDGES_MST = cpuBoruvkaMST(ES, NUM_EDGES, NUM_VERTICES, inputCSR(input), mstEdges,
+                                      rounds, finish, numThreads);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } else if (engine == ENGINE_COMPRESSED) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        NUM_EDGES_MST = compressedBoruvkaMST(compressed, mstEdges, rounds, finish, numThreads);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } else if (engine == ENGINE_EXTERNAL) {
+        NUM_EDGES_MST = RunExternalEngine(ES, input, generator.input, external, numThreads,
+                                          mstEdges, rounds, finish, externalStats, ms);
+        if (NUM_EDGES_MST < 0)
+            return 1;
+    } else {
+        NUM_EDGES_MST = RunDeviceEngine(context, ES, inputCSR(input), numThreads,
+                                        mode, finish, mstEdges, rounds, ms);
+        if (NUM_EDGES_MST < 0)
+            return 1;
+    }
 
-        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-        total_time = time_end - time_start;
-        printf("\nExecution time in milliseconds = %0.3f ms\n\n", (total_time/1000000.0));
-    //////////////////////////////////////////////////////////////////////////////////////////////////////////
+    int t = NUM_EDGES_MST;
+
+    /* The edge list engines give indices into ES, the compressed one ids
+    *  of its own sorted edges
+    */
+    if (engine == ENGINE_COMPRESSED) {
+        parallelFor(t, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++)
+                mst[i] = decodeEdge(compressed, mstEdges[i]);
+        });
+    } else if (engine != ENGINE_DENSE) {
+        parallelFor(t, numThreads, [&](int begin, int end) {
+            for(int i = begin; i < end; i++)
+                mst[i] = ES[mstEdges[i]];
+        });
+    }
 
-    /* Releases the allocated resources */
-    Cleanup(context, commandQueue, program, kernel, memObjects);
+    /* MST Cost */
+    long long cost = parallelReduce<long long>(t, numThreads, ZERO, [&](int begin, int end) {
+        return isa().sumWeights(mst + begin, end - begin);
+    }, [](long long a, long long b) { return a + b; });
+
+    /* MST edges, to stdout inside the report or to the output file */
+    bool listed = output.format == OUTPUT_TEXT && outputToStdout(output);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (listed)
+        cout << endl << "MST [" << endl;
+    Output_Status written = writeMST(output, mst, t, NUM_VERTICES, numThreads);
+    if (listed)
+        cout << "]" << endl;
+    double outputMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (written != OUTPUT_OK) {
+        cerr << "Error writing the MST to " << (outputToStdout(output) ? "stdout" : output.path)
+             << ": " << outputStatusNames[written] << endl;
+        return 1;
+    }
+    cout << endl << "MST Cost :: " << cost;
+    cout << endl << "Boruvka Rounds :: " << rounds;
+    if (finish.finished)
+        cout << endl << "Finish :: " << finishNames[finish.algorithm] << " on the Host";
+    if (engine == ENGINE_DENSE)
+        cout << endl << "Engine :: dense " << denseNames[dense] << ", " << numThreads << " thread(s)";
+    else if (engine == ENGINE_CPU)
+        cout << endl << "Engine :: CPU, " << numThreads << " thread(s)";
+    else if (engine == ENGINE_COMPRESSED)
+        cout << endl << "Engine :: CPU over the compressed adjacency, " << numThreads
+             << " thread(s)";
+    else if (engine == ENGINE_EXTERNAL)
+        cout << endl << "Engine :: semi-external, spill files in " << external.spillDir;
+    else
+        cout << endl << "Min-Edge Selection :: " << minEdgeModeNames[mode];
+    cout << endl << "Host ISA :: " << isaNames[isa().level];
+    if (generator.input != NULL)
+        printf("\nInput :: %d vertices, %d edges, %s in %0.3f ms",
+               NUM_VERTICES, NUM_EDGES, input.description, input.ms);
+    if (engine == ENGINE_COMPRESSED)
+        printf("\nCompressed :: %llu bytes, %0.2f per edge, in %0.3f ms",
+               (unsigned long long) compressedBytes(compressed),
+               (double) compressedBytes(compressed) / (NUM_EDGES > 0 ? NUM_EDGES : 1), compressMs);
+    if (engine == ENGINE_EXTERNAL)
+        printf("\nExternal :: %0.1f MB read, %0.1f MB written, %d spill round(s)",
+               externalStats.bytesRead / 1048576.0, externalStats.bytesWritten / 1048576.0,
+               externalStats.spillRounds);
+    if (output.format != OUTPUT_NONE)
+        printf("\nMST Output :: %s to %s in %0.3f ms", outputFormatNames[output.format],
+               outputToStdout(output) ? "stdout" : output.path, outputMs);
+    printf("\nExecution time in milliseconds = %0.3f ms\n\n", ms);
+
+    delete [] mstEdges;
+    delete [] mst;
+    if (engine == ENGINE_COMPRESSED)
+        freeCompressedGraph(compressed);
+    if (input.edges != NULL)
+        freeInputGraph(input);
+    else
+        delete [] ES;
+    freeMatrix(adjMatrix);
 
     return 0;
 }
@@ -0,0 +1,202 @@
+/* scan_bench.cpp
+*
+*  Micro-benchmark of the exclusive scan primitives: the multi-threaded
+*  host scan (common/scan.h) and the OpenCL scan (device_scan.h), for
+*  every element type. Reports the bandwidth of each and checks the
+*  results against a serial scan.
+*
+*/
+
+/* Including required libraries */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <stdint.h>
+#include <CL/cl.h>
+
+#include "../common/scan.h"
+#include "cl_utils.h"
+#include "device_scan.h"
+
+using namespace std;
+
+/* Preprocessor Directives */
+#define DEFAULT_ELEMENTS (1 << 24)
+#define DEFAULT_ITERATIONS 10
+
+/* Milliseconds elapsed since start */
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/* Checks a scan against a serial one */
+template <typename T>
+bool checkScan(const T* in, const T* out, int n) {
+    T running = 0;
+
+    for(int i = 0; i < n; i++) {
+        if (out[i] != running) return false;
+        running += in[i];
+    }
+
+    return true;
+}
+
+/* Prints one benchmark line - a scan reads and writes every element once */
+void report(const char* engine, const char* type, int n, size_t size, double ms, bool ok) {
+    double gbs = (2.0 * n * size) / (ms * 1e6);
+
+    printf("%-8s %-6s %12d elements %10.3f ms %8.2f GB/s  %s\n",
+           engine, type, n, ms, gbs, ok ? "ok" : "WRONG");
+}
+
+/* Benchmarks the host scan of one element type */
+template <typename T>
+bool benchHost(const char* type, int n, int numThreads, int iterations) {
+    T* in = new T[n];
+    T* out = new T[n];
+
+    for(int i = 0; i < n; i++)
+        in[i] = (T) (rand() % 16);
+
+    exclusiveScan(in, out, n, numThreads);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++)
+        exclusiveScan(in, out, n, numThreads);
+    double ms = elapsedMs(start) / iterations;
+
+    bool ok = checkScan(in, out, n);
+    report("host", type, n, sizeof(T), ms, ok);
+
+    delete [] in;
+    delete [] out;
+    return ok;
+}
+
+/* Benchmarks the device scan of one element type */
+template <typename T>
+bool benchDevice(cl_context context, cl_command_queue commandQueue, Device_Scan &scan,
+                 Scan_Type scanType, int n, int iterations) {
+    T* in = new T[n];
+    T* out = new T[n];
+    T total = 0;
+    bool ok = false;
+
+    for(int i = 0; i < n; i++)
+        in[i] = (T) (rand() % 16);
+
+    cl_mem data = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(T) * n, NULL, NULL);
+    if (data == NULL) {
+        cerr << "Error creating memory objects." << endl;
+        delete [] in;
+        delete [] out;
+        return false;
+    }
+
+    /* The first run warms up the Kernels */
+    double ms = 0;
+    for(int i = 0; i <= iterations; i++) {
+        clEnqueueWriteBuffer(commandQueue, data, CL_TRUE, 0, sizeof(T) * n, in, 0, NULL, NULL);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (!ScanDevice(commandQueue, scan, scanType, data, n, NULL)) break;
+        clFinish(commandQueue);
+        if (i > 0) ms += elapsedMs(start);
+
+        ok = (i == iterations);
+    }
+
+    /* Checks the scan and its total */
+    if (ok) {
+        T sum = 0;
+        for(int i = 0; i < n; i++)
+            sum += in[i];
+
+        clEnqueueWriteBuffer(commandQueue, data, CL_TRUE, 0, sizeof(T) * n, in, 0, NULL, NULL);
+        ok = ScanDevice(commandQueue, scan, scanType, data, n, &total)
+          && clEnqueueReadBuffer(commandQueue, data, CL_TRUE, 0, sizeof(T) * n, out,
+                                 0, NULL, NULL) == CL_SUCCESS
+          && checkScan(in, out, n) && total == sum;
+        report("device", scanTypeNames[scanType], n, sizeof(T), ms / iterations, ok);
+    }
+
+    clReleaseMemObject(data);
+    delete [] in;
+    delete [] out;
+    return ok;
+}
+
+/* Main function */
+int main(int argc, char** argv) {
+    int n = DEFAULT_ELEMENTS
+    ,   iterations = DEFAULT_ITERATIONS
+    ,   numThreads = hardwareThreads();
+    bool ok = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--elements") == 0 && i + 1 < argc) {
+            n = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc && selectIsa(argv[i + 1])) {
+            i++;
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--elements N] [--iterations N] [--threads N]"
+                 << " [--isa scalar|avx2|avx512]" << endl;
+            return 1;
+        }
+    }
+
+    if (n <= 0 || iterations <= 0 || numThreads <= 0) {
+        cerr << "Elements, iterations and threads have to be positive." << endl;
+        return 1;
+    }
+
+    configureHostPool(numThreads, false);
+
+    cout << "Host scan, " << numThreads << " thread(s), " << isaNames[isa().level] << endl;
+    ok &= benchHost<int32_t>("int", n, numThreads, iterations);
+    ok &= benchHost<uint32_t>("uint", n, numThreads, iterations);
+    ok &= benchHost<int64_t>("long", n, numThreads, iterations);
+    ok &= benchHost<uint64_t>("ulong", n, numThreads, iterations);
+
+    /* The device scan needs an OpenCL platform */
+    cl_device_id device = 0;
+    cl_command_queue commandQueue = 0;
+    cl_program program = 0;
+    cl_context context = CreateContext();
+    Device_Scan scan;
+
+    if (context == NULL) {
+        cout << "No OpenCL platform, skipping the device scan." << endl;
+        return ok ? 0 : 1;
+    }
+
+    commandQueue = CreateCommandQueue(context, &device);
+    if (commandQueue != NULL)
+        program = CreateProgram(context, device, "_kernel.cl");
+
+    if (program != NULL && CreateDeviceScan(context, program, device, n, scan)) {
+        cout << endl << "Device scan, work-group size " << scan.localSize << endl;
+        ok &= benchDevice<cl_int>(context, commandQueue, scan, SCAN_INT, n, iterations);
+        ok &= benchDevice<cl_uint>(context, commandQueue, scan, SCAN_UINT, n, iterations);
+        ok &= benchDevice<cl_long>(context, commandQueue, scan, SCAN_LONG, n, iterations);
+        ok &= benchDevice<cl_ulong>(context, commandQueue, scan, SCAN_ULONG, n, iterations);
+        ReleaseDeviceScan(scan);
+    } else {
+        ok = false;
+    }
+
+    /* Releases the allocated resources */
+    if (program != 0) clReleaseProgram(program);
+    if (commandQueue != 0) clReleaseCommandQueue(commandQueue);
+    clReleaseContext(context);
+
+    return ok ? 0 : 1;
+}
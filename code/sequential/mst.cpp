@@ -11,123 +11,62 @@
 #include <sstream>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
+#include <algorithm>
+
+#include "../common/graph.h"
+#include "../common/matrix.h"
+#include "../common/union_find.h"
+#include "../common/compact.h"
+#include "../common/radix_sort.h"
+#include "../common/isa_dispatch.h"
+#include "../common/random_graph.h"
+#include "../common/text_graph.h"
+#include "../common/mst_writer.h"
 
 using namespace std;
 
 /* Preprocessor Directives */
 #define MAX_WEIGHT 15
-#define NUM_VERTICES 6
+#define DEFAULT_VERTICES 6
 #define ZERO 0
 
 /* Global variables */
-int NUM_EDGES = ZERO
+int NUM_VERTICES = DEFAULT_VERTICES
+, 	NUM_EDGES = ZERO
 , 	NUM_EDGES_MST = ZERO;
 
-/* struct(ure) Forest holds information about the edge 
-*  
-*  value => value of the node
-*  rank => rank of the node - used for linking
-*  parent => Forest_Node type node for maintaining tree hierarchy
-*/
-
-struct Forest_Node {
-    int value
-    ,	rank;
-    struct Forest_Node* parent;
-};
-
-/* Creates a list - one per element */
-Forest_Node* MakeSet(int value) {
-	Forest_Node* node = (Forest_Node *) new Forest_Node;
-
-	node->value = value;
-	node->parent = NULL;
-	node->rank = 0;
-	
-	return node;
-}
-
-/* Finds the root of the node */
-Forest_Node* Find(Forest_Node* node) {
-	Forest_Node* temp;
-	Forest_Node* root = node;
-
-	while (root->parent != NULL)
-		root = root->parent;
-	
-	/* Updates the parent pointers */
-	while (node->parent != NULL) {
-		temp = node->parent;
-		node->parent = root;
-		node = temp;
-	}
-	
-	return root;
-}
-
-/* Merges two nodes based on their rank */
-void Union(Forest_Node* node1, Forest_Node* node2) {
-	Forest_Node* root1 = Find(node1);
-	Forest_Node* root2 = Find(node2);
-
-	if (root1->rank > root2->rank) { 
-		root2->parent = root1; 
-	} else if (root2->rank > root1->rank) { 
-		root1->parent = root2; 
-	} else {
-		root2->parent = root1; 
-		root1->rank++; 
-	}
-}
-
-/* struct(ure) Edge holds information about the edge 
-*  
-*  v1 => vertex 1
-*  v2 => vertex 2
-*  w => weight of the edge
+/* Creates an adjacency matrix, one contiguous aligned block
+*
+*  data is NULL if the matrix can't be allocated
 */
-struct Edge {
-    int v1
-    ,	v2
-    ,	w;
-};
+Dense_Matrix createAdjacencyMatrix() {
+	Dense_Matrix adjMatrix = createMatrix(NUM_VERTICES, NUM_VERTICES, false);
+	if(adjMatrix.data == NULL) return adjMatrix;
 
-/* Creates an adjacency matrix */
-int** createAdjacencyMatrix() {
-    int** adjMatrix = new int*[NUM_VERTICES];
+	/* Initializes all nodes (and the row padding) to ZERO */
+	memset(adjMatrix.data, 0, adjMatrix.bytes);
 
-    for(int i = 0; i < NUM_VERTICES; i++)
-        adjMatrix[i] = new int[NUM_VERTICES];
-
-    /* Initializes all nodes to ZERO */
-    for(int i = 0; i < NUM_VERTICES; i++)
-        for(int j = 0; j < NUM_VERTICES; j++)
-            adjMatrix[i][j] = 0;
-
-    return adjMatrix;
+	return adjMatrix;
 }
 
-/* Generates an adjacency matrix based random graph
+/* Generates an adjacency matrix based random graph (fillMatrixGraph),
+*  the same one pmst generates from the same seed
 *
 *  count => total (valid) edge count
+*  generator => seed and maxWeight of the graph
+*  data is NULL if the matrix can't be allocated
 */
 
-int** generateRandomGraph(int &count) {
-    int** adjMatrix = createAdjacencyMatrix();
-
-    srand(time(NULL));
-    for(int i = 0; i < NUM_VERTICES; i++) {
-        for(int j = 0; j < NUM_VERTICES; j++) {
-            if (i == j) continue;
-            adjMatrix[i][j] = (rand() % MAX_WEIGHT) - 1;
-            adjMatrix[j][i] = adjMatrix[i][j];
-            
-            if(adjMatrix[i][j] > 0)
-                count++;
-        }
-    }
+Dense_Matrix generateRandomGraph(int &count, const Generator_Options &generator) {
+	Dense_Matrix adjMatrix = createAdjacencyMatrix();
 
-    return adjMatrix;
+	count = ZERO;
+	if(adjMatrix.data == NULL) return adjMatrix;
+
+	count = fillMatrixGraph(adjMatrix, generator, 1);
+
+	return adjMatrix;
 }
 
 /* Displays edges list */
@@ -140,107 +79,272 @@ void displayEdgeList(Edge* E, int size) {
 }
 
 /* Displays adjacency matrix */
-void displayAdjacencyMatrix(int** adjMatrix) {
+void displayAdjacencyMatrix(const Dense_Matrix &adjMatrix) {
     cout << endl << "Adjacency Matrix [" << endl;
-    for(int i = 0; i < NUM_VERTICES; i++) {
+    for(int i = 0; i < adjMatrix.numRows; i++) {
+        const int* row = matrixRow(adjMatrix, i);
+
         cout << "\t{";
-        for(int j = 0; j < NUM_VERTICES; j++) {
-            cout << " " << adjMatrix[i][j] << " ";
+        for(int j = 0; j < adjMatrix.numCols; j++) {
+            cout << " " << row[j] << " ";
         }
         cout << "}" << endl;
     }
     cout << "]" << endl;
 }
 
-int main(){
-	// Generates a random Graph
-	int **adjMatrix = generateRandomGraph(NUM_EDGES)
-	,			  c = 0;
-
-	NUM_EDGES--;
-
-	Edge *ES = new Edge[NUM_EDGES]
-	,	  *E = new Edge[NUM_EDGES];
-
-	/* Extracts edges' info from Adjacency Matrix */
-	for(int i = 0; i < NUM_VERTICES; i++) {
-		for(int j = 0; j < NUM_VERTICES; j++) {
-			if(i == j) continue;
-			if(adjMatrix[i][j] > 0 && c < NUM_EDGES) {
-				ES[c].v1 = i;
-				ES[c].v2 = j;
-				ES[c].w = adjMatrix[i][j];
-				c++;
-			}
+/* Finds the minimum outgoing edge of every component - the graph is
+*  built over the component labels, so each component scans only its
+*  own adjacency slice and every entry leaves the component. The slice's
+*  weights and edge indices are separate arrays, scanned with SIMD.
+*
+*  Ties on the weight go to the smaller edge index, so that every
+*  component agrees on one and the same minimum edge.
+*
+*  cheapest => index of the minimum edge per component (-1 if none)
+*/
+void findMinEdges(CSR_Graph &graph, int* cheapest) {
+	for(int c = 0; c < graph.numVertices; c++) {
+		int first = graph.offsets[c];
+
+		cheapest[c] = minEdgeInSlice(graph.weights + first, graph.edgeIds + first,
+									 graph.offsets[c + 1] - first);
+	}
+}
+
+/* Runs a single Boruvka round: hooks every component along its
+*  minimum edge and relabels the vertices with their new component
+*
+*  E => live edges between the components, numEdges => their count
+*  ids => original index of every live edge into ES
+*  forest => disjoint sets of the vertices
+*  mst => MST edges found so far, t => number of those edges
+*  returns the number of edges added in this round
+*/
+int boruvkaRound(Edge* E, int* ids, int numEdges, Edge* ES, Union_Find &forest,
+				 int* comp, int* cheapest, Edge* mst, int &t) {
+	int numVertices = forest.numElements
+	,	added = 0;
+
+	CSR_Graph graph = buildCSR(E, numEdges, numVertices);
+	findMinEdges(graph, cheapest);
+	freeCSR(graph);
+
+	/* Contracts the components along their minimum edges */
+	for(int i = 0; i < numVertices; i++) {
+		if(cheapest[i] == -1) continue;
+
+		Edge edge = E[cheapest[i]];
+		if(Union(forest, edge.v1, edge.v2)) {
+			mst[t] = ES[ids[cheapest[i]]];
+			t += 1;
+			added++;
 		}
 	}
 
-	displayAdjacencyMatrix(adjMatrix);
-    //displayEdgeList(ES, NUM_EDGES);
+	/* Relabels every vertex with the root of its component */
+	for(int i = 0; i < numVertices; i++)
+		comp[i] = Find(forest, i);
 
-	int min;
-	c = 0;
-
-	/* Gets minimum edge for each vertex */
-	for(int i = 0; i < NUM_VERTICES; i++) {
-		min = 9999;
-		int index = -1;
-		for(int j = 0; j < NUM_EDGES; j++) {
-			if(ES[j].v1 == i && ES[j].w <= min){
-				min = ES[j].w;
-				index = j;
-			}
+	return added;
+}
 
-			if(ES[j].v1 > i) break;
-		}
+/* Finds the MST of the graph using Boruvka's rounds - a spanning
+*  forest if the graph isn't connected
+*
+*  Between the rounds the edge list is compacted: edges inside a
+*  component are dropped and the live ones get their endpoints rewritten
+*  to component labels. The live edges are then radix sorted by
+*  (v1, v2, weight) and only the lightest of every bundle of parallel
+*  edges is kept, so every round works on a simple graph.
+*
+*  ES => edge list of the graph
+*  mst => output buffer, holds at least numVertices - 1 edges
+*  rounds => number of Boruvka rounds it took
+*  returns the number of MST edges
+*/
+int boruvkaMST(Edge* ES, int numEdges, int numVertices, Edge* mst, int &rounds) {
+	Union_Find forest = MakeSets(numVertices);
+	int* comp = new int[numVertices];
+	int* cheapest = new int[numVertices];
+	Edge* E = new Edge[numEdges];
+	Edge* EO = new Edge[numEdges];
+	int* ids = new int[numEdges];
+	int* idsOut = new int[numEdges];
+
+	int minWeight = 0
+	,	maxWeight = 0;
+
+	isa().weightRange(ES, numEdges, &minWeight, &maxWeight);
+
+	/* A self-loop of the input never joins two components - left in, it
+	*  could be the minimum edge of its vertex and stop the rounds early
+	*/
+	int live = 0;
+
+	for(int i = 0; i < numEdges; i++) {
+		if(ES[i].v1 == ES[i].v2) continue;
+
+		E[live] = ES[i];
+		ids[live++] = i;
+	}
+	numEdges = live;
 
-		if(index != -1){
-			E[c].v1 = i;
-			E[c].v2 = ES[index].v2;
-			E[c].w = ES[index].w;
-			c++;
-		}
+	int components = numVertices
+	,	t = 0;
+
+	rounds = 0;
+	while(components > 1) {
+		int added = boruvkaRound(E, ids, numEdges, ES, forest, comp, cheapest, mst, t);
+
+		/* No edges left between the components */
+		if(added == 0) break;
+
+		components -= added;
+		rounds++;
+
+		/* Drops the edges that became self-loops */
+		numEdges = compactEdges(E, ids, numEdges, comp, EO, idsOut, 1);
+		swap(E, EO);
+		swap(ids, idsOut);
+
+		/* Keeps the lightest of the parallel edges */
+		radixSortEdges(E, ids, numEdges, numVertices, minWeight, maxWeight, EO, idsOut, 1);
+		numEdges = uniqueEdges(E, ids, numEdges, EO, idsOut, 1);
+		swap(E, EO);
+		swap(ids, idsOut);
 	}
 
-	NUM_EDGES_MST = c;
-	cout << endl;
-	
-	/* Displays all min edges */
-    //displayEdgeList(E, NUM_EDGES_MST);
+	FreeSets(forest);
+	delete [] comp;
+	delete [] cheapest;
+	delete [] E;
+	delete [] EO;
+	delete [] ids;
+	delete [] idsOut;
+
+	return t;
+}
 
-	/* Creates the forest */
-	Forest_Node** forest = new Forest_Node*[NUM_VERTICES];
+/* Main function
+*
+*  --isa scalar|avx2|avx512 => instruction set of the hot loops, the
+*                              default is the widest the CPU supports
+*  --graph, --vertices, ... => the random graph, see parseGeneratorOption
+*  --output FILE, --output-format F => where and how the MST is written,
+*                                      see parseOutputOption
+*/
+int main(int argc, char** argv){
+	Generator_Options generator = defaultGeneratorOptions(DEFAULT_VERTICES, MAX_WEIGHT,
+														  (uint64_t) time(NULL));
+	Output_Options output = defaultOutputOptions();
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--isa") == 0 && i + 1 < argc && selectIsa(argv[i + 1])) {
+			i++;
+		} else if(!parseGeneratorOption(argc, argv, i, generator)
+				  && !parseOutputOption(argc, argv, i, output)) {
+			cerr << "Usage: " << argv[0] << " [--isa scalar|avx2|avx512]"
+				 << " [--graph matrix|gnp|gnm|rmat|grid2d|grid3d|geometric|knn] [--vertices N]"
+				 << " [--edges M] [--probability P] [--scale S] [--edge-factor F] [--rmat A,B,C,D]"
+				 << " [--radius R] [--neighbors K]"
+				 << " [--weights uniform|constant|exponential] [--max-weight W] [--seed S]"
+				 << " [--connected] [--input FILE [--verify]] [--output FILE|-]"
+				 << " [--output-format text|binary|delta|none]" << endl;
+			return 1;
+		}
+	}
+	if(output.format == OUTPUT_BINARY && outputToStdout(output)) {
+		cerr << "Error: " << outputStatusNames[OUTPUT_BINARY_STDOUT] << endl;
+		return 1;
+	}
 
-	for(int i = 0; i < NUM_VERTICES; i++)
-		forest[i] = MakeSet(i);
+	NUM_VERTICES = generator.numVertices;
 
-	int e = 0
-	, 	t = 0;
+	// Reads the input graph, or generates a random Graph
+	Dense_Matrix adjMatrix = Dense_Matrix();
+	Input_Graph input = Input_Graph();
+	Edge *ES = NULL;
 
-	Edge* mst = new Edge[NUM_EDGES];
+	if(generator.input != NULL) {
+		if(!loadInputGraph(generator, 1, input)) {
+			cerr << "Error reading " << input.description << endl;
+			return 1;
+		}
 
-	while(e < NUM_EDGES_MST) {
-		int v1 = E[e].v1;
-		int v2 = E[e].v2;
+		ES = input.edges;
+		NUM_VERTICES = input.numVertices;
+		NUM_EDGES = input.numEdges;
+	} else if(generator.model == GRAPH_MATRIX) {
+		adjMatrix = generateRandomGraph(NUM_EDGES, generator);
+		if(adjMatrix.data == NULL) {
+			cerr << "Error allocating the adjacency matrix." << endl;
+			return 1;
+		}
+		ES = new Edge[NUM_EDGES];
+
+		/* Extracts edges' info from Adjacency Matrix */
+		int c = 0;
+		for(int i = 0; i < NUM_VERTICES; i++) {
+			const int* row = matrixRow(adjMatrix, i);
+
+			for(int j = i + 1; j < NUM_VERTICES; j++) {
+				if(row[j] > 0 && c < NUM_EDGES) {
+					ES[c].v1 = i;
+					ES[c].v2 = j;
+					ES[c].w = row[j];
+					c++;
+				}
+			}
+		}
 
-		if(Find(forest[v1]) != Find(forest[v2])) {
-			mst[t] = E[e];
-			Union(forest[v1], forest[v2]);
-			t += 1;
+		if(NUM_VERTICES <= 30)
+			displayAdjacencyMatrix(adjMatrix);
+	} else {
+		/* Samples the edge list straight, without a matrix */
+		ES = generateEdgeList(generator, NUM_EDGES, 1);
+		if(ES == NULL) {
+			cerr << "Error generating the graph, more than " << INT_MAX << " edges?" << endl;
+			return 1;
 		}
-		e++;
 	}
+    //displayEdgeList(ES, NUM_EDGES);
+
+	/* Runs Boruvka's rounds until a single component is left */
+	Edge* mst = new Edge[NUM_VERTICES];
+	int rounds = 0;
+	int t = boruvkaMST(ES, NUM_EDGES, NUM_VERTICES, mst, rounds);
+
+	NUM_EDGES_MST = t;
+	cout << endl;
 
 	/* MST Cost */
-	int cost = 0;
+	long long cost = isa().sumWeights(mst, t);
 
-	cout << endl << "MST [" << endl;
-	for(int i = 0; i < t; i++){
-        cout << "\t{" << mst[i].v1 << ", " << mst[i].v2 << "}" << endl;
-        cost += mst[i].w;
-    }
-    cout << "]" << endl;
+	/* MST edges, to stdout inside the report or to the output file */
+	bool listed = output.format == OUTPUT_TEXT && outputToStdout(output);
+
+	if(listed)
+		cout << endl << "MST [" << endl;
+	Output_Status written = writeMST(output, mst, t, NUM_VERTICES, 1);
+	if(listed)
+		cout << "]" << endl;
+
+	if(written != OUTPUT_OK) {
+		cerr << "Error writing the MST to " << (outputToStdout(output) ? "stdout" : output.path)
+			 << ": " << outputStatusNames[written] << endl;
+		return 1;
+	}
 	cout << endl << "MST Cost :: " << cost << endl;
+	cout << "Boruvka Rounds :: " << rounds << endl;
+	cout << "ISA :: " << isaNames[isa().level] << endl;
+
+	if(input.edges != NULL)
+		freeInputGraph(input);
+	else
+		delete [] ES;
+	delete [] mst;
+	freeMatrix(adjMatrix);
 
 	return 0;
 }
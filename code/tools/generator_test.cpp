@@ -0,0 +1,82 @@
+/* generator_test.cpp
+*
+*  Checks of the G(n, m) generator (common/random_graph.h): exactly m
+*  distinct edges, sorted by (v1, v2) with v1 < v2, and the same graph
+*  whatever the number of threads - from sparse requests up to the
+*  complete graph, where sampling the edges one by one would stall.
+*
+*/
+
+/* Including required libraries */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include "../common/graph.h"
+#include "../common/parallel.h"
+#include "../common/random_graph.h"
+
+using namespace std;
+
+/* Preprocessor Directives */
+#define TEST_VERTICES 2000
+#define MAX_WEIGHT 1000
+
+/* Checks one G(n, m) request, returns false on a failure */
+bool checkGnm(int numVertices, long long numEdges, uint64_t seed) {
+    Generator_Options options = defaultGeneratorOptions(numVertices, MAX_WEIGHT, seed);
+    long long pairs = (long long) numPairs(numVertices)
+    ,         wanted = numEdges < pairs ? numEdges : pairs;
+    const int threads[] = { 1, 3, 8 };
+    Edge* first = NULL;
+    bool ok = true;
+
+    options.model = GRAPH_GNM;
+    options.numEdges = numEdges;
+
+    for(int t = 0; t < 3 && ok; t++) {
+        configureHostPool(threads[t], false);
+
+        int count = 0;
+        Edge* E = generateEdgeList(options, count, threads[t]);
+
+        ok = E != NULL && count == wanted;
+        for(int i = 0; i < count && ok; i++) {
+            ok = E[i].v1 < E[i].v2 && E[i].v1 >= 0 && E[i].v2 < numVertices
+              && (i == 0 || E[i - 1].v1 < E[i].v1
+                  || (E[i - 1].v1 == E[i].v1 && E[i - 1].v2 < E[i].v2));
+        }
+
+        if (ok && first != NULL)
+            ok = memcmp(first, E, count * sizeof(Edge)) == 0;
+
+        if (first == NULL) first = E;
+        else delete [] E;
+    }
+
+    cout << "G(" << numVertices << ", " << numEdges << ") :: " << (ok ? "ok" : "FAILED") << endl;
+
+    delete [] first;
+    return ok;
+}
+
+/* Main function */
+int main() {
+    long long pairs = (long long) numPairs(TEST_VERTICES);
+    const long long requests[] = {
+        0, 1, 5000, pairs / 2, pairs / 2 + 1, 9 * pairs / 10, pairs - 1000, pairs - 1, pairs,
+        pairs + 1
+    };
+    bool ok = true;
+
+    for(size_t r = 0; r < sizeof(requests) / sizeof(requests[0]); r++)
+        ok = checkGnm(TEST_VERTICES, requests[r], 42 + r) && ok;
+
+    /* Tiny graphs hit the edge cases of both samplers */
+    for(int n = 1; n <= 6; n++)
+        for(long long m = 0; m <= (long long) numPairs(n); m++)
+            ok = checkGnm(n, m, 7) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/* graph_convert.cpp
+*
+*  Converter to the binary graph file (common/graph_file.h): writes a
+*  text graph (DIMACS, SNAP or Matrix Market, common/text_graph.h), a
+*  random graph of any edge list model, or rewrites a graph file (say, to
+*  add or drop its edge ids, in place if --output is the --input file).
+*  Without --output it only describes the graph it read or generated.
+*
+*/
+
+/* Including required libraries */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <chrono>
+#include <stdint.h>
+
+#include "../common/graph.h"
+#include "../common/parallel.h"
+#include "../common/random_graph.h"
+#include "../common/graph_file.h"
+#include "../common/text_graph.h"
+#include "../common/compressed_graph.h"
+
+using namespace std;
+
+/* Preprocessor Directives */
+#define DEFAULT_VERTICES 1000
+#define MAX_WEIGHT 1000
+
+/* Milliseconds elapsed since start */
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/* Main function
+*
+*  --output FILE => graph file to write
+*  --no-edge-ids => leaves the edge ids out of it
+*  --threads N => threads of the parser, the generator and the writer
+*  --graph, --vertices, ..., --input FILE => the graph, see parseGeneratorOption
+*/
+int main(int argc, char** argv) {
+    Generator_Options generator = defaultGeneratorOptions(DEFAULT_VERTICES, MAX_WEIGHT,
+                                                          (uint64_t) time(NULL));
+    const char* output = NULL;
+    bool edgeIds = true;
+    int numThreads = hardwareThreads();
+
+    generator.model = GRAPH_GNM;
+    generator.numEdges = 8 * DEFAULT_VERTICES;
+
+    /* A graph file is read through anyway, its indices are checked too */
+    generator.verify = true;
+
+    for(int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--no-edge-ids") == 0) {
+            edgeIds = false;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            numThreads = atoi(argv[++i]);
+        } else if (!parseGeneratorOption(argc, argv, i, generator)
+                   || (generator.model == GRAPH_MATRIX && generator.input == NULL)) {
+            cerr << "Usage: " << argv[0] << " [--output FILE] [--no-edge-ids] [--threads N]"
+                 << " [--input FILE | --graph gnp|gnm|rmat|grid2d|grid3d|geometric|knn"
+                 << " [graph options]]" << endl;
+            return 1;
+        }
+    }
+
+    configureHostPool(numThreads, false);
+
+    /* Reads or generates the graph */
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Input_Graph input = Input_Graph();
+    Edge* E = NULL;
+    int numEdges = 0
+    ,   numVertices = 0;
+
+    if (generator.input != NULL) {
+        if (!loadInputGraph(generator, numThreads, input)) {
+            cerr << "Error reading " << input.description << endl;
+            return 1;
+        }
+
+        E = input.edges;
+        numEdges = input.numEdges;
+        numVertices = input.numVertices;
+    } else {
+        E = generateEdgeList(generator, numEdges, numThreads);
+        if (E == NULL) {
+            cerr << "Error generating the graph, more than " << INT_MAX << " edges?" << endl;
+            return 1;
+        }
+        numVertices = generator.numVertices;
+    }
+
+    printf("Graph :: %d vertices, %d edges, %s in %0.3f ms\n", numVertices, numEdges,
+           generator.input != NULL ? input.description : "generated", elapsedMs(start));
+    if (input.mapped.base != NULL)
+        printf("Edge ids :: %s\n", input.mapped.csr.edgeIds != NULL ? "yes" : "no");
+
+    /* The edges section goes out sorted by (v1, v2), without parallel
+    *  edges, so that the compressed engine takes it as is
+    */
+    Edge* sorted = NULL;
+
+    if (output != NULL && !strictlySorted(E, numEdges, numVertices, numThreads)) {
+        int count = 0;
+
+        start = chrono::steady_clock::now();
+        sorted = normalizeEdgeList(E, numEdges, numVertices, count, numThreads);
+        printf("Sorted :: %d edges left of %d in %0.3f ms\n", count, numEdges, elapsedMs(start));
+
+        if (input.edges == NULL) delete [] E;
+        E = sorted;
+        numEdges = count;
+    }
+
+    /* Writes the graph file */
+    int result = 0;
+
+    if (output != NULL) {
+        /* Written aside then renamed over output: the input may be that
+        *  very file, still mapped, and truncating it would pull the edges
+        *  from under the writer
+        */
+        char temporary[4096];
+
+        snprintf(temporary, sizeof(temporary), "%s.tmp", output);
+        start = chrono::steady_clock::now();
+        Graph_File_Status status = writeGraphFile(temporary, E, numEdges, numVertices, edgeIds,
+                                                  numThreads);
+
+        if (status == GRAPH_FILE_OK && rename(temporary, output) != 0)
+            status = GRAPH_FILE_WRITE;
+
+        if (status != GRAPH_FILE_OK) {
+            remove(temporary);
+            cerr << "Error writing " << output << ": " << graphFileStatusNames[status] << endl;
+            result = 1;
+        } else {
+            printf("Written :: %s in %0.3f ms\n", output, elapsedMs(start));
+        }
+    }
+
+    if (input.edges == NULL || sorted != NULL)
+        delete [] E;
+    if (input.edges != NULL)
+        freeInputGraph(input);
+
+    return result;
+}
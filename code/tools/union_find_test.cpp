@@ -0,0 +1,185 @@
+/* union_find_test.cpp
+*
+*  Checks of the lock-free union-find (common/concurrent_union_find.h)
+*  against the serial one (common/union_find.h): hooking the same edges
+*  from many threads must give the same forest as the serial Union loop.
+*
+*  any edges => same sets and as many merges as the serial loop
+*  Boruvka candidates => the minimum edge of every vertex; those form a
+*                        forest, so exactly the edges the serial loop
+*                        keeps are accepted, whatever the interleaving
+*
+*/
+
+/* Including required libraries */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
+#include "../common/graph.h"
+#include "../common/parallel.h"
+#include "../common/random_graph.h"
+#include "../common/union_find.h"
+#include "../common/concurrent_union_find.h"
+
+using namespace std;
+
+/* Preprocessor Directives */
+#define MAX_WEIGHT 1000
+#define ROUNDS 20
+
+/* Smallest element of the set of every element - a label that doesn't
+*  depend on which root the set got
+*/
+template <typename Root>
+void setLabels(int numVertices, int* label, Root root) {
+    int* smallest = new int[numVertices];
+
+    for(int v = 0; v < numVertices; v++)
+        smallest[v] = numVertices;
+    for(int v = 0; v < numVertices; v++) {
+        int r = root(v);
+        if (v < smallest[r]) smallest[r] = v;
+    }
+    for(int v = 0; v < numVertices; v++)
+        label[v] = smallest[root(v)];
+
+    delete [] smallest;
+}
+
+/* Hooks the edges listed in edges, serially and on numThreads threads,
+*  returns false on a failure
+*
+*  forest => the edges form a forest up to repeats, the accepted ones
+*            have to be the serial ones
+*/
+bool checkHook(const Edge* E, const int* edges, int count, int numVertices, bool forest,
+               int numThreads) {
+    Union_Find serial = MakeSets(numVertices);
+    Concurrent_Union_Find uf = MakeConcurrentSets(numVertices);
+    char* serialKept = new char[count + 1];
+    char* accepted = new char[count + 1];
+    int* serialLabel = new int[numVertices];
+    int* label = new int[numVertices];
+    int serialMerges = 0;
+    std::atomic<int> merges(0);
+    bool ok = true;
+
+    for(int i = 0; i < count; i++) {
+        serialKept[i] = Union(serial, E[edges[i]].v1, E[edges[i]].v2) ? 1 : 0;
+        serialMerges += serialKept[i];
+    }
+
+    parallelFor(count, numThreads, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            accepted[i] = UnionConcurrent(uf, E[edges[i]].v1, E[edges[i]].v2) ? 1 : 0;
+            if (accepted[i]) merges.fetch_add(1);
+        }
+    });
+
+    setLabels(numVertices, serialLabel, [&](int v) { return (int) Find(serial, v); });
+    setLabels(numVertices, label, [&](int v) { return (int) FindConcurrent(uf, v); });
+
+    ok = merges.load() == serialMerges
+      && memcmp(serialLabel, label, numVertices * sizeof(int)) == 0;
+
+    /* A repeated edge may be accepted at any of its copies */
+    for(int i = 0; i < count && ok && forest; ) {
+        int first = i
+        ,   kept = 0
+        ,   taken = 0;
+
+        for(; i < count && edges[i] == edges[first]; i++) {
+            kept += serialKept[i];
+            taken += accepted[i];
+        }
+        ok = kept == taken;
+    }
+
+    FreeSets(serial);
+    FreeConcurrentSets(uf);
+    delete [] serialKept;
+    delete [] accepted;
+    delete [] serialLabel;
+    delete [] label;
+
+    return ok;
+}
+
+/* Checks both edge sets of one random graph, returns false on a failure */
+bool checkGraph(Graph_Model model, int numVertices, long long numEdges, uint64_t seed) {
+    Generator_Options options = defaultGeneratorOptions(numVertices, MAX_WEIGHT, seed);
+    int count = 0;
+
+    options.model = model;
+    options.numEdges = numEdges;
+
+    Edge* E = generateEdgeList(options, count, 1);
+    if (E == NULL) return false;
+
+    /* Any edges: all of them, in order */
+    int* all = new int[count + 1];
+
+    for(int i = 0; i < count; i++)
+        all[i] = i;
+
+    /* Boruvka candidates: the minimum (weight, index) edge of every
+    *  vertex, sorted so that the two picks of one edge sit together
+    */
+    int* best = new int[numVertices];
+    int* candidates = new int[numVertices + 1];
+    int numCandidates = 0;
+
+    for(int v = 0; v < numVertices; v++)
+        best[v] = -1;
+    for(int i = 0; i < count; i++) {
+        int ends[2] = { E[i].v1, E[i].v2 };
+
+        for(int k = 0; k < 2; k++) {
+            int b = best[ends[k]];
+
+            if (b < 0 || E[i].w < E[b].w || (E[i].w == E[b].w && i < b))
+                best[ends[k]] = i;
+        }
+    }
+    for(int v = 0; v < numVertices; v++)
+        if (best[v] >= 0) candidates[numCandidates++] = best[v];
+
+    std::sort(candidates, candidates + numCandidates);
+
+    const int threads[] = { 1, 3, 8 };
+    bool ok = true;
+
+    for(int t = 0; t < 3; t++) {
+        configureHostPool(threads[t], false);
+
+        for(int r = 0; r < ROUNDS && ok; r++) {
+            ok = checkHook(E, all, count, numVertices, false, threads[t])
+              && checkHook(E, candidates, numCandidates, numVertices, true, threads[t]);
+        }
+    }
+
+    cout << graphModelNames[model] << "(" << numVertices << ", " << count << ") :: "
+         << (ok ? "ok" : "FAILED") << endl;
+
+    delete [] E;
+    delete [] all;
+    delete [] best;
+    delete [] candidates;
+    return ok;
+}
+
+/* Main function */
+int main() {
+    bool ok = true;
+
+    ok = checkGraph(GRAPH_GNM, 1000, 3000, 1) && ok;
+    ok = checkGraph(GRAPH_GNM, 20000, 200000, 2) && ok;
+    ok = checkGraph(GRAPH_RMAT, 1 << 14, 0, 3) && ok;
+    ok = checkGraph(GRAPH_GRID2D, 10000, 0, 4) && ok;
+
+    return ok ? 0 : 1;
+}